@@ -1,64 +1,78 @@
 #include "buffer/buffer.h"
 #include <assert.h>
-#include <sys/uio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <new>
+#include "util/scan.h"
 
 CircleBuffer::CircleBuffer(int initBufferSize, std::string end)
-    : m_buffer(initBufferSize), m_end(std::move(end)), m_readPos(0), m_writePos(0) {}
-
-// 读出所有数据
-ssize_t CircleBuffer::readOut(int fd)
+    : m_buffer(nullptr), m_capacity(0), m_end(std::move(end)), m_readPos(0), m_size(0)
 {
-    if (m_readPos <= m_writePos) {
-        ssize_t len = write(fd, readAddress(), readableBytes());
-        m_readPos = m_writePos;
-        return len;
-    } else {
-        ssize_t len_1 = write(fd, readAddress(), m_buffer.size() - 1 - m_readPos);
-        ssize_t len_2 = write(fd, &m_buffer[0], m_writePos);
-        m_readPos = m_writePos;
-        return len_1 + len_2;
-    }
+    // 映射的大小必须是页的整数倍
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t size = std::max(initBufferSize, 1);
+    m_capacity = (size + page - 1) / page * page;
+    m_buffer = mapMirror(m_capacity);
 }
 
-ssize_t CircleBuffer::writeIn(int fd)
+CircleBuffer::~CircleBuffer()
 {
-    char buff[65536];
-    struct iovec iov[3];
+    unmapMirror(m_buffer, m_capacity);
+}
 
-    if (m_writePos < m_readPos)
-    {
-        iov[0].iov_base = &m_buffer[m_writePos];
-        iov[0].iov_len = m_readPos - m_writePos;
-        iov[1].iov_base = nullptr;
-        iov[1].iov_len = 0;
+char* CircleBuffer::mapMirror(size_t capacity)
+{
+    int fd = memfd_create("circleBuffer", MFD_CLOEXEC);
+    if (fd < 0) throw std::bad_alloc();
+    if (ftruncate(fd, capacity) < 0) {
+        close(fd);
+        throw std::bad_alloc();
+    }
+    // 先占住连续的两倍地址空间，再把同一个文件映射到前后两半
+    void* base = mmap(nullptr, capacity * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        throw std::bad_alloc();
     }
-    else
-    {
-        iov[0].iov_base = &m_buffer[m_writePos];
-        iov[0].iov_len = m_buffer.size() - m_writePos;
-        iov[1].iov_base = &m_buffer[0];
-        iov[1].iov_len = m_readPos;
+    char* buffer = static_cast<char*>(base);
+    void* first = mmap(buffer, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    void* second = mmap(buffer + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    // 映射会持有文件，关闭fd后内存仍然有效
+    close(fd);
+    if (first == MAP_FAILED || second == MAP_FAILED) {
+        munmap(base, capacity * 2);
+        throw std::bad_alloc();
     }
+    return buffer;
+}
 
-    iov[2].iov_base = buff;
-    iov[2].iov_len = sizeof(buff);
+void CircleBuffer::unmapMirror(char* buffer, size_t capacity)
+{
+    if (buffer) munmap(buffer, capacity * 2);
+}
 
-    ssize_t len = readv(fd, iov, 3);
-    if (len <= 0) {
-        return -1;
+ssize_t CircleBuffer::readOut(int fd)
+{
+    if (m_size == 0) return 0;
+    ssize_t len = write(fd, readAddress(), m_size);
+    if (len > 0) {
+        retrieve(len);
     }
+    return len;
+}
 
-    // 更新读写指针和Append操作
-    if (static_cast<size_t>(len) <= iov[0].iov_len) {
-        m_writePos += len;
-    } else if (static_cast<size_t>(len) <= iov[0].iov_len + iov[1].iov_len) {
-        m_writePos = iov[0].iov_len + iov[1].iov_len - len;
-    } else {
-        if (m_buffer.size() - 1 >= len) ;
-        else ;
+ssize_t CircleBuffer::writeIn(int fd)
+{
+    if (writeableBytes() == 0) {
+        ensureWriteable(m_capacity + 1);
+    }
+    // 可写区域是连续的，一次read就够了，读不完的数据留在内核中等下一次
+    ssize_t len = read(fd, writeAddress(), writeableBytes());
+    if (len <= 0) {
         return -1;
     }
-
+    m_size += len;
     return len;
 }
 
@@ -79,128 +93,55 @@ void CircleBuffer::Append(const CircleBuffer &buff)
 
 void CircleBuffer::Append(const char *str, size_t len)
 {
-    assert(str);
-    ensureWriteable(len, &Errno);
-    if (Errno != 0) return;
-    writeToBuffer(str, len);
+    assert(str || len == 0);
+    ensureWriteable(len);
+    memcpy(writeAddress(), str, len);
+    m_size += len;
 }
 
 std::string CircleBuffer::getReadableBytes()
 {
-    // 修正
-    if (m_readPos == m_buffer.size() - 1) m_readPos = 0;
-
-    if (m_readPos <= m_writePos)
-    {
-        std::string res(m_buffer.begin() + m_readPos, m_buffer.begin() + m_writePos);
-        m_readPos = m_writePos;
-        return res;
-    }
-    else
-    {
-        std::string s1(m_buffer.begin() + m_readPos, m_buffer.end() - 1);
-        std::string s2(m_buffer.begin(), m_buffer.begin() + m_writePos);
-        m_readPos = m_writePos;
-        return s1 + s2;
-    }
+    std::string res(readAddress(), m_size);
+    reset();
+    return res;
 }
 
 std::string CircleBuffer::getByEndBytes()
 {
-    std::string res;
-    size_t endPos = 0;
-
-    if (m_readPos < m_writePos) {
-        std::string data = std::string(m_buffer.begin() + m_readPos, m_buffer.begin() + m_writePos);
-        if ((endPos = data.find(m_end)) != std::string::npos) {
-            // 找到结束符，提取数据并更新读指针
-            res = data.substr(0, endPos + m_end.length());
-            m_readPos += res.size();
-            return res.substr(0, res.size() - m_end.size());
-        }
-    } else if (m_readPos > m_writePos) {
-        // 右区间，两边，左区间
-        std::string data_right = std::string(m_buffer.begin() + m_readPos, m_buffer.end() - 1);
-        std::string data_left = std::string(m_buffer.begin(), m_buffer.begin() + m_writePos);
-        std::string data = data_right + data_left;
-
-        if ((endPos = data.find(m_end)) != std::string::npos) {
-            if (endPos + m_end.size() <= data_right.size()) {
-                res = data_right.substr(0, endPos + m_end.size());
-                m_readPos += res.size();
-            } else if (endPos >= data_left.size()) {
-                size_t part_in_left = endPos - data_right.size();
-                res = data_right + data_left.substr(0, part_in_left + m_end.size());
-                m_readPos = part_in_left + m_end.size();
-            } else {
-                int remaing_left = m_end.size() - (data_right.size() - endPos);
-                res = data_right + data_left.substr(0, remaing_left);
-                m_readPos = remaing_left;
-            }
-            return res.substr(0, res.size() - m_end.size());
-        }
+    const char* begin = readAddress();
+    const char* end = begin + m_size;
+    const char* pos;
+    if (m_end == "\r\n") {
+        pos = scan::findCRLF(begin, end);
+    } else {
+        pos = std::search(begin, end, m_end.begin(), m_end.end());
     }
-
-    return res;
-}
-
-size_t CircleBuffer::readableBytes() const
-{
-    if (m_readPos <= m_writePos) return m_writePos - m_readPos;
-    else {
-        return m_buffer.size() - 1 - m_readPos + m_writePos;
+    if (pos == end) {
+        return "";
     }
+    std::string res(begin, pos);
+    retrieve(pos - begin + m_end.size());
+    return res;
 }
 
-size_t CircleBuffer::writeableBytes() const
+void CircleBuffer::retrieve(size_t len)
 {
-    return m_buffer.size() - 1 - readableBytes();
+    assert(len <= m_size);
+    m_size -= len;
+    m_readPos = m_size == 0 ? 0 : (m_readPos + len) % m_capacity;
 }
 
-void CircleBuffer::writeToBuffer(const char *str, size_t len)
+void CircleBuffer::ensureWriteable(size_t len)
 {
-    // 修正写位置
-    if (m_writePos == m_buffer.size() - 1) m_writePos = 0;
-
-    if (m_writePos < m_readPos)
-    {
-        std::copy(str, str + len, m_buffer.begin() + m_writePos);
-        m_writePos += len;
-        return;
-    }
-    else
-    {
-        int distance = m_buffer.size() - m_writePos - 1;
-        if (distance >= len) {
-            std::copy(str, str + len, m_buffer.begin() + m_writePos);
-            m_writePos += len;
-            return;
-        } else {
-            std::copy(str, str + distance, m_buffer.begin() + m_writePos);
-            std::copy(str + distance, str + len, m_buffer.begin());
-            m_writePos = len - distance;
-            return;
-        }
+    if (writeableBytes() >= len) return;
+    size_t capacity = m_capacity;
+    while (capacity - m_size < len) {
+        capacity *= 2;
     }
+    char* buffer = mapMirror(capacity);
+    memcpy(buffer, readAddress(), m_size);
+    unmapMirror(m_buffer, m_capacity);
+    m_buffer = buffer;
+    m_capacity = capacity;
+    m_readPos = 0;
 }
-
-const char *CircleBuffer::readAddress() const
-{
-    return &m_buffer[m_readPos];
-}
-
-void CircleBuffer::ensureWriteable(size_t len, int* Errno)
-{
-    size_t space = writeableBytes();
-    // 立即写，不能写，等待写
-    if (space >= len) {
-        *Errno = 0;
-        return;
-    } else if (len > m_buffer.size() - 1) {
-        *Errno = ENOMEM;
-        return;
-    } else {
-        *Errno = EAGAIN;
-        return;
-    }
-}
\ No newline at end of file
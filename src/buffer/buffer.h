@@ -1,34 +1,56 @@
 #pragma once
 
 #include <iostream>
+#include <string>
 #include <vector>
 #include <unistd.h>
 
+/*
+环形缓冲区，同一段memfd内存连续映射两次，[0, cap)和[cap, 2cap)是同一块物理页
+可读区域和可写区域即使跨过环的末尾在地址上也是连续的：
+读写只需要一个iovec，解析器可以直接在readAddress()上扫描，不需要拼接字符串
+空间不足时扩大一倍，不会丢弃数据
+容量按页对齐，缓冲区不是线程安全的
+*/
 class CircleBuffer {
 public:
-    // 有一个额外空间是标示位置
     CircleBuffer(int initBufferSize = 10000 + 1, std::string end = "\r\n");
+    ~CircleBuffer();
+
+    CircleBuffer(const CircleBuffer&) = delete;
+    CircleBuffer& operator=(const CircleBuffer&) = delete;
+
+    // 把数据写入fd，返回写出的字节数
     ssize_t readOut(int fd);
+    // 从fd读入数据，缓冲区满时先扩容
     ssize_t writeIn(int fd);
     void Append(const std::string& str);
     void Append(const char* str, size_t len);
     void Append(const CircleBuffer& buff);
     void Append(const void* data, size_t len);
     std::string getReadableBytes();
+    // 取出第一个结束符之前的数据，不包含结束符，没有结束符时返回空串
     std::string getByEndBytes();
-    size_t getCurBufferSize() const {return m_buffer.size() - 1;}
-    size_t readableBytes() const;
-    void reset() {m_readPos = m_writePos = 0;}
+    size_t getCurBufferSize() const {return m_capacity;}
+    size_t readableBytes() const {return m_size;}
+    size_t writeableBytes() const {return m_capacity - m_size;}
+    void reset() {m_readPos = 0; m_size = 0;}
+
+    // 可读数据的起始地址，之后的readableBytes()个字节是连续的
+    const char* readAddress() const {return m_buffer + m_readPos;}
+    void retrieve(size_t len);
 
 private:
-    std::vector<char> m_buffer;
+    char* m_buffer;
+    size_t m_capacity;
     std::string m_end;
-    std::size_t m_readPos;
-    std::size_t m_writePos;
-    int Errno;
+    // m_readPos总是小于m_capacity，写位置是m_readPos + m_size
+    size_t m_readPos;
+    size_t m_size;
 
-    size_t writeableBytes() const;
-    void writeToBuffer(const char* str, size_t len);
-    const char* readAddress() const;
-    void ensureWriteable(size_t len, int* Errno);
-};
\ No newline at end of file
+    char* writeAddress() {return m_buffer + m_readPos + m_size;}
+    void ensureWriteable(size_t len);
+    // 分配两次映射的内存，失败时抛出std::bad_alloc
+    static char* mapMirror(size_t capacity);
+    static void unmapMirror(char* buffer, size_t capacity);
+};
@@ -0,0 +1,187 @@
+#include "buffer/bufferPool.h"
+#include <sched.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include "util/affinity.h"
+
+// 不析构：线程退出时归还缓存需要缓冲池一直存在，即使是在静态对象析构之后
+BufferPool* BufferPool::getInstance()
+{
+    static BufferPool* pool = new BufferPool;
+    return pool;
+}
+
+BufferPool::BufferPool(): m_inUse(0)
+{
+    for (auto& created : m_created) {
+        created.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t BufferPool::cacheLimit(int sizeClass)
+{
+    size_t limit = BUFFER_CACHE_MEMORY / classSize(sizeClass);
+    return std::max<size_t>(2, std::min<size_t>(BUFFER_CACHE_BLOCKS, limit));
+}
+
+BufferPool::ThreadCache::ThreadCache()
+{
+    for (int i = 0; i < BUFFER_CLASS_NUM; ++ i) {
+        blocks[i].reserve(cacheLimit(i));
+    }
+}
+
+BufferPool::ThreadCache::~ThreadCache()
+{
+    for (int i = 0; i < BUFFER_CLASS_NUM; ++ i) {
+        getInstance()->flush(blocks[i].data(), blocks[i].size(), i);
+    }
+}
+
+BufferPool::ThreadCache& BufferPool::threadCache()
+{
+    static thread_local ThreadCache cache;
+    return cache;
+}
+
+int BufferPool::currentNode()
+{
+    static thread_local int node = -1;
+    if (node < 0) {
+        int cpu = sched_getcpu();
+        node = (cpu >= 0 ? affinity::numaNode(cpu) : 0) % BUFFER_NUMA_NODES;
+    }
+    return node;
+}
+
+char* BufferPool::allocate(size_t size, size_t& capacity, int& sizeClass)
+{
+    sizeClass = 0;
+    while (sizeClass < BUFFER_CLASS_NUM && classSize(sizeClass) < size) {
+        ++ sizeClass;
+    }
+
+    char* buf = nullptr;
+    if (sizeClass < BUFFER_CLASS_NUM) {
+        std::vector<char*>& cache = threadCache().blocks[sizeClass];
+        if (!cache.empty() || refill(cache, sizeClass)) {
+            buf = cache.back();
+            cache.pop_back();
+        } else {
+            buf = newBlock(sizeClass);
+        }
+    }
+    if (buf != nullptr) {
+        capacity = classSize(sizeClass);
+    } else {
+        sizeClass = -1;
+        capacity = size;
+        buf = new char[size];
+    }
+    m_inUse.fetch_add(capacity, std::memory_order_relaxed);
+    return buf;
+}
+
+void BufferPool::deallocate(char* buf, size_t capacity, int sizeClass)
+{
+    if (buf == nullptr) return;
+    m_inUse.fetch_sub(capacity, std::memory_order_relaxed);
+    if (sizeClass < 0) {
+        delete[] buf;
+        return;
+    }
+    // 缓存满了，把先放入的一半还给全局空闲链表，刚归还的块留在本线程
+    std::vector<char*>& cache = threadCache().blocks[sizeClass];
+    size_t limit = cacheLimit(sizeClass);
+    if (cache.size() >= limit) {
+        flush(cache.data(), limit / 2, sizeClass);
+        cache.erase(cache.begin(), cache.begin() + limit / 2);
+    }
+    cache.push_back(buf);
+}
+
+size_t BufferPool::idle()
+{
+    size_t bytes = 0;
+    for (int i = 0; i < BUFFER_CLASS_NUM; ++ i) {
+        for (auto& list : m_free[i]) {
+            std::lock_guard<std::mutex> lock(list.mtx);
+            bytes += list.blocks.size() * classSize(i);
+        }
+    }
+    return bytes;
+}
+
+void BufferPool::trim()
+{
+    for (int i = 0; i < BUFFER_CLASS_NUM; ++ i) {
+        for (auto& list : m_free[i]) {
+            std::vector<char*> blocks;
+            {
+                std::lock_guard<std::mutex> lock(list.mtx);
+                blocks.swap(list.blocks);
+            }
+            for (char* buf : blocks) {
+                freeBlock(buf, i);
+            }
+        }
+    }
+}
+
+char* BufferPool::newBlock(int sizeClass)
+{
+    size_t size = classSize(sizeClass);
+    if (m_created[sizeClass].fetch_add(1, std::memory_order_relaxed) >= BUFFER_CLASS_MEMORY / size) {
+        m_created[sizeClass].fetch_sub(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    if (size < BUFFER_MMAP_SIZE) {
+        return new char[size];
+    }
+    void* buf = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED) {
+        m_created[sizeClass].fetch_sub(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return static_cast<char*>(buf);
+}
+
+void BufferPool::freeBlock(char* buf, int sizeClass)
+{
+    size_t size = classSize(sizeClass);
+    if (size < BUFFER_MMAP_SIZE) {
+        delete[] buf;
+    } else {
+        munmap(buf, size);
+    }
+    m_created[sizeClass].fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool BufferPool::refill(std::vector<char*>& cache, int sizeClass)
+{
+    // 本节点没有空闲的块时分配新块，不从其它节点拿
+    FreeList& list = m_free[sizeClass][currentNode()];
+    size_t batch = cacheLimit(sizeClass) / 2;
+    std::lock_guard<std::mutex> lock(list.mtx);
+    size_t count = std::min(batch, list.blocks.size());
+    cache.insert(cache.end(), list.blocks.end() - count, list.blocks.end());
+    list.blocks.resize(list.blocks.size() - count);
+    return count > 0;
+}
+
+void BufferPool::flush(char* const* blocks, size_t count, int sizeClass)
+{
+    if (count == 0) return;
+    FreeList& list = m_free[sizeClass][currentNode()];
+    size_t maxIdle = BUFFER_IDLE_MEMORY / classSize(sizeClass);
+    size_t kept = 0;
+    {
+        std::lock_guard<std::mutex> lock(list.mtx);
+        while (kept < count && list.blocks.size() < maxIdle) {
+            list.blocks.push_back(blocks[kept ++]);
+        }
+    }
+    for (size_t i = kept; i < count; ++ i) {
+        freeBlock(blocks[i], sizeClass);
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// 最小的一级缓冲区，每一级是上一级的4倍：4K、16K、64K、256K
+#define BUFFER_MIN_SIZE 4096
+#define BUFFER_CLASS_NUM 4
+// 每一级最多创建的内存，超过之后直接向系统分配
+#define BUFFER_CLASS_MEMORY (64 * 1024 * 1024)
+// 线程缓存每一级最多保存的块数和内存，大的级别按内存限制，256K一级每个线程只缓存4块
+#define BUFFER_CACHE_BLOCKS 32
+#define BUFFER_CACHE_MEMORY (1024 * 1024)
+// 每个NUMA节点每一级空闲内存的上限，超过的块直接还给系统
+#define BUFFER_IDLE_MEMORY (8 * 1024 * 1024)
+// 不小于这个大小的块直接mmap，还给系统时立即释放物理内存
+#define BUFFER_MMAP_SIZE (64 * 1024)
+#define BUFFER_NUMA_NODES 8
+
+/*
+I/O缓冲区的分级内存池
+连接只在有数据收发时才借用缓冲区，空闲时归还，常驻内存和活跃连接数成正比，而不是和打开的连接数成正比
+每个线程有自己的缓存，借用和归还通常不需要同步；缓存空了从全局空闲链表取一半，缓存满了归还一半
+全局空闲链表按NUMA节点分开，线程只和自己所在节点的链表交换，内存由哪个节点的线程首次写入就留在哪个节点
+空闲内存有上限：线程缓存按内存限制块数，全局空闲链表超过BUFFER_IDLE_MEMORY的块直接还给系统，trim还给系统全部空闲的块
+超过最大一级的缓冲区和某一级达到上限后的分配直接使用new，释放时直接归还系统
+*/
+class BufferPool {
+public:
+    static BufferPool* getInstance();
+
+    // 分配至少size字节，capacity返回实际大小，sizeClass返回所属的级别，直接分配时为-1
+    char* allocate(size_t size, size_t& capacity, int& sizeClass);
+    void deallocate(char* buf, size_t capacity, int sizeClass);
+
+    static size_t classSize(int sizeClass) { return (size_t)BUFFER_MIN_SIZE << (2 * sizeClass); }
+    // 线程缓存中每一级最多保存的块数
+    static size_t cacheLimit(int sizeClass);
+    // 当前借出的内存，包括直接分配的
+    size_t inUse() const { return m_inUse.load(std::memory_order_relaxed); }
+    // 全局空闲链表中的内存，不包括线程缓存
+    size_t idle();
+    // 把全局空闲链表中的块全部还给系统
+    void trim();
+
+private:
+    // 只由所属线程访问，线程退出时还给全局空闲链表
+    struct ThreadCache {
+        std::vector<char*> blocks[BUFFER_CLASS_NUM];
+        ThreadCache();
+        ~ThreadCache();
+    };
+    struct FreeList {
+        std::mutex mtx;
+        std::vector<char*> blocks;
+    };
+
+    BufferPool();
+    ~BufferPool() = default;
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    static ThreadCache& threadCache();
+    // 当前线程第一次使用时所在的NUMA节点
+    static int currentNode();
+
+    char* newBlock(int sizeClass);
+    void freeBlock(char* buf, int sizeClass);
+    bool refill(std::vector<char*>& cache, int sizeClass);
+    // 放入当前节点的全局空闲链表，超过上限的还给系统
+    void flush(char* const* blocks, size_t count, int sizeClass);
+
+    FreeList m_free[BUFFER_CLASS_NUM][BUFFER_NUMA_NODES];
+    // 每一级还没有还给系统的块数
+    std::atomic<size_t> m_created[BUFFER_CLASS_NUM];
+    std::atomic<size_t> m_inUse;
+};
@@ -0,0 +1,190 @@
+#include "buffer/chainBuffer.h"
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <algorithm>
+
+ChainBuffer::ChainBuffer(): m_head(0), m_bytes(0), m_chunkUsed(0)
+{
+    // 保证缓冲池比持有缓冲区的静态对象后析构
+    BufferPool::getInstance();
+}
+
+ChainBuffer::~ChainBuffer()
+{
+    clear();
+}
+
+void ChainBuffer::append(const char* data, size_t len)
+{
+    if (len == 0) return;
+    Chunk* chunk = m_chunks.empty() ? nullptr : &m_chunks.back();
+    if (chunk == nullptr || chunk->capacity - m_chunkUsed < len) {
+        Chunk c;
+        c.data = BufferPool::getInstance()->allocate(std::max<size_t>(len, BUFFER_MIN_SIZE), c.capacity, c.sizeClass);
+        m_chunks.push_back(c);
+        m_chunkUsed = 0;
+        chunk = &m_chunks.back();
+    }
+    char* dest = chunk->data + m_chunkUsed;
+    memcpy(dest, data, len);
+    m_chunkUsed += len;
+
+    // 紧接着上一次复制的数据时合并成一个切片
+    if (m_slices.size() > m_head) {
+        Slice& last = m_slices.back();
+        if (last.fd < 0 && last.data + last.len == dest) {
+            last.len += len;
+            m_bytes += len;
+            return;
+        }
+    }
+    pushSlice(dest, len, -1, 0);
+}
+
+void ChainBuffer::appendStatic(const char* data, size_t len)
+{
+    if (len == 0) return;
+    pushSlice(data, len, -1, 0);
+}
+
+void ChainBuffer::appendRef(const char* data, size_t len, std::shared_ptr<const void> holder)
+{
+    if (len == 0) return;
+    // 同一个对象连续引用多次时只持有一次
+    if (m_holders.empty() || m_holders.back() != holder) {
+        m_holders.push_back(std::move(holder));
+    }
+    pushSlice(data, len, -1, 0);
+}
+
+void ChainBuffer::appendFile(int fd, off_t offset, size_t len, std::shared_ptr<const void> holder)
+{
+    if (len == 0) return;
+    if (m_holders.empty() || m_holders.back() != holder) {
+        m_holders.push_back(std::move(holder));
+    }
+    pushSlice(nullptr, len, fd, offset);
+}
+
+void ChainBuffer::pushSlice(const char* data, size_t len, int fd, off_t offset)
+{
+    m_slices.push_back({data, len, fd, offset});
+    m_bytes += len;
+}
+
+ssize_t ChainBuffer::writeFd(int fd, int* Errno)
+{
+    ssize_t len = 0;
+    while (m_head < m_slices.size()) {
+        if (m_slices[m_head].fd >= 0) {
+            len = sendFile(fd, m_slices[m_head], Errno);
+            if (len < 0) return len;
+            continue;
+        }
+
+        // 文件之前的内存切片一次发送，后面还有文件时带MSG_MORE
+        iovec iov[IOV_MAX];
+        size_t count = 0;
+        bool more = false;
+        for (size_t i = m_head; i < m_slices.size() && count < IOV_MAX; ++ i) {
+            if (m_slices[i].fd >= 0) {
+                more = true;
+                break;
+            }
+            iov[count].iov_base = const_cast<char*>(m_slices[i].data);
+            iov[count].iov_len = m_slices[i].len;
+            ++ count;
+        }
+        msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        len = sendmsg(fd, &msg, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+        if (len <= 0) {
+            *Errno = errno;
+            return len;
+        }
+        consume(len);
+    }
+    clear();
+    return len;
+}
+
+ssize_t ChainBuffer::sendFile(int fd, Slice& slice, int* Errno)
+{
+    ssize_t len = -1;
+    while (slice.len > 0) {
+        len = sendfile(fd, slice.fd, &slice.offset, slice.len);
+        if (len <= 0) {
+            // 返回0说明文件在发送过程中被截断了
+            *Errno = len == 0 ? EIO : errno;
+            return -1;
+        }
+        slice.len -= len;
+        m_bytes -= len;
+    }
+    ++ m_head;
+    return len;
+}
+
+size_t ChainBuffer::peek(std::vector<iovec>& iov) const
+{
+    size_t bytes = 0;
+    for (size_t i = m_head; i < m_slices.size() && m_slices[i].fd < 0; ++ i) {
+        iov.push_back({const_cast<char*>(m_slices[i].data), m_slices[i].len});
+        bytes += m_slices[i].len;
+    }
+    return bytes;
+}
+
+void ChainBuffer::retrieve(size_t len)
+{
+    assert(len <= m_bytes);
+    consume(len);
+    if (m_bytes == 0) {
+        clear();
+    }
+}
+
+void ChainBuffer::consume(size_t len)
+{
+    m_bytes -= len;
+    while (len > 0) {
+        Slice& slice = m_slices[m_head];
+        if (len >= slice.len) {
+            len -= slice.len;
+            ++ m_head;
+        } else {
+            slice.data += len;
+            slice.len -= len;
+            len = 0;
+        }
+    }
+}
+
+std::string ChainBuffer::toString() const
+{
+    std::string result;
+    for (size_t i = m_head; i < m_slices.size(); ++ i) {
+        if (m_slices[i].fd < 0) {
+            result.append(m_slices[i].data, m_slices[i].len);
+        }
+    }
+    return result;
+}
+
+void ChainBuffer::clear()
+{
+    m_slices.clear();
+    m_head = 0;
+    m_bytes = 0;
+    m_holders.clear();
+    for (auto& chunk : m_chunks) {
+        BufferPool::getInstance()->deallocate(chunk.data, chunk.capacity, chunk.sizeClass);
+    }
+    m_chunks.clear();
+    m_chunkUsed = 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "buffer/bufferPool.h"
+
+/*
+写路径使用的链式缓冲区，由一串切片组成，一次sendmsg最多发送IOV_MAX个切片
+切片可以是：
+    缓冲区自己的内存，append的小段数据复制到从BufferPool借来的块中，相邻的合并成一个切片
+    静态数据，比如字符串常量，不复制也不持有
+    外部内存，比如缓存的响应和映射的文件，由引用计数持有，发送完之前不会被释放
+    文件区间，用sendfile发送，前面的数据带MSG_MORE发送，和文件内容组成完整的报文段
+多个流水线响应追加到同一条链上，一起发送
+缓冲区不是线程安全的
+*/
+class ChainBuffer {
+public:
+    ChainBuffer();
+    ~ChainBuffer();
+
+    ChainBuffer(const ChainBuffer&) = delete;
+    ChainBuffer& operator=(const ChainBuffer&) = delete;
+
+    void append(const char* data, size_t len);
+    void append(const std::string& str) { append(str.data(), str.size()); }
+    // data在发送完之前必须一直有效
+    void appendStatic(const char* data, size_t len);
+    // holder持有data所在的内存，发送完或者clear之后才释放
+    void appendRef(const char* data, size_t len, std::shared_ptr<const void> holder);
+    // 发送fd中[offset, offset + len)的内容，holder保证fd在发送完之前不被关闭
+    void appendFile(int fd, off_t offset, size_t len, std::shared_ptr<const void> holder);
+
+    // 一直发送到EAGAIN或者全部发送完，返回最后一次系统调用的返回值，出错时设置Errno
+    // 全部发送完之后释放所有引用和借用的内存
+    ssize_t writeFd(int fd, int* Errno);
+    // 由调用者自己发送（比如io_uring）：peek把未发送的内存切片依次放进iov，遇到文件切片时停止，返回放入的字节数
+    // 发送完len个字节之后调用retrieve，全部发送完时释放所有引用和借用的内存
+    size_t peek(std::vector<iovec>& iov) const;
+    void retrieve(size_t len);
+
+    size_t readAbleBytes() const { return m_bytes; }
+    size_t sliceCount() const { return m_slices.size() - m_head; }
+    // 未发送的内存切片拼在一起，跳过文件切片
+    std::string toString() const;
+    // 丢弃未发送的数据
+    void clear();
+
+private:
+    // fd小于0时是内存切片
+    struct Slice {
+        const char* data;
+        size_t len;
+        int fd;
+        off_t offset;
+    };
+    struct Chunk {
+        char* data;
+        size_t capacity;
+        int sizeClass;
+    };
+
+    void pushSlice(const char* data, size_t len, int fd, off_t offset);
+    void consume(size_t len);
+    ssize_t sendFile(int fd, Slice& slice, int* Errno);
+
+    std::vector<Slice> m_slices;
+    // 第一个没有发送完的切片
+    size_t m_head;
+    size_t m_bytes;
+    std::vector<std::shared_ptr<const void>> m_holders;
+    std::vector<Chunk> m_chunks;
+    // 最后一块中已经使用的字节数
+    size_t m_chunkUsed;
+};
@@ -1,38 +1,54 @@
 #include "linearBuffer.h"
 #include <algorithm>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include "util/scan.h"
 
-LinearBuffer::LinearBuffer(size_t capacity): m_readPos(0), m_writePos(0), m_buffer(capacity)
+LinearBuffer::LinearBuffer(size_t capacity): m_readPos(0), m_writePos(0), m_buffer(nullptr), m_capacity(0),
+                                             m_sizeClass(-1), m_initCapacity(capacity),
+                                             m_readHint(capacity), m_readFull(false)
 {
+    // 保证缓冲池先于持有缓冲区的静态对象（比如日志）构造完成，从而在它们之后析构
+    BufferPool::getInstance();
+}
+
+LinearBuffer::~LinearBuffer()
+{
+    BufferPool::getInstance()->deallocate(m_buffer, m_capacity, m_sizeClass);
 }
 
 ssize_t LinearBuffer::readFd(int fd, int *Errno)
 {
-    char tempBuff[65535];
-    struct iovec iov[2];
+    // 按之前观察到的读入大小预留空间，直接读进缓冲区，不经过栈上的临时缓冲区
+    // 上一次读满时内核中可能还有大量数据，这时才问内核还剩多少，一次预留足够的空间
+    size_t want = m_readHint;
+    int pending = 0;
+    if (m_readFull && ioctl(fd, FIONREAD, &pending) == 0) {
+        // 没有数据时只是为了读到EAGAIN或者EOF，有一个字节的空间就够了
+        want = pending > 0 ? pending : 1;
+    }
+    ensureWritable(want);
     size_t writable = remainCapacity();
 
-    // 配置 iovec 结构，用于分散读
-    iov[0].iov_base = &m_buffer[m_writePos];
-    iov[0].iov_len = writable;
-    iov[1].iov_base = tempBuff;
-    iov[1].iov_len = sizeof(tempBuff);
-
-    ssize_t len = readv(fd, iov, 2);
+    ssize_t len = read(fd, m_buffer + m_writePos, writable);
+    m_readFull = len > 0 && static_cast<size_t>(len) == writable;
     if (len < 0) {
         *Errno = errno;
-    } else if (static_cast<size_t>(len) <= writable) {
-        m_writePos += len;
+        return len;
+    }
+    m_writePos += len;
+    // 读满说明可能还有数据，下次多预留一些
+    if (m_readFull) {
+        m_readHint = std::min<size_t>(std::max(m_readHint, writable) * 2, LINEAR_READ_HINT_MAX);
     } else {
-        m_writePos = m_buffer.size();
-        append(tempBuff, static_cast<size_t>(len - writable));
+        m_readHint = std::max(static_cast<size_t>(len), m_initCapacity);
     }
-
     return len;
 }
 
 ssize_t LinearBuffer::writeFd(int fd, int *Errno)
 {
-    ssize_t len = write(fd, &m_buffer[m_readPos], readAbleBytes());
+    ssize_t len = write(fd, m_buffer + m_readPos, readAbleBytes());
     if (len < 0) {
         *Errno = errno;
         return len;
@@ -48,23 +64,26 @@ void LinearBuffer::append(const std::string &str)
 
 void LinearBuffer::append(const char *str, size_t len)
 {
-    size_t curSize = remainCapacity();
-    if (curSize < len) {
-        size_t newCapacity = len - curSize + m_buffer.size();
-        expandSpace(newCapacity);
-    }
-    writeToBuffer(str, len);
+    ensureWritable(len);
+    memcpy(m_buffer + m_writePos, str, len);
+    m_writePos += len;
 }
 
 std::string LinearBuffer::getByEndFlag(const std::string &endFlag)
 {
-    auto it = std::search(m_buffer.begin() + m_readPos, m_buffer.begin() + m_writePos,
-                          endFlag.begin(), endFlag.end());
-    if (it == m_buffer.begin() + m_writePos) {
+    const char* begin = m_buffer + m_readPos;
+    const char* end = m_buffer + m_writePos;
+    const char* it;
+    if (endFlag == "\r\n") {
+        it = scan::findCRLF(begin, end);
+    } else {
+        it = std::search(begin, end, endFlag.begin(), endFlag.end());
+    }
+    if (it == end) {
         return "";
     } else {
-        std::string result(m_buffer.begin() + m_readPos, it);
-        m_readPos = std::distance(m_buffer.begin(), it) + endFlag.size();
+        std::string result(begin, it);
+        m_readPos = it - m_buffer + endFlag.size();
         return result;
     }
 }
@@ -76,7 +95,7 @@ size_t LinearBuffer::readAbleBytes() const
 
 std::string LinearBuffer::getReadAbleBytes()
 {
-    std::string result(m_buffer.begin() + m_readPos, m_buffer.begin() + m_writePos);
+    std::string result(m_buffer + m_readPos, readAbleBytes());
     m_readPos = m_writePos = 0;
     return result;
 }
@@ -86,7 +105,7 @@ std::string LinearBuffer::getDataByLength(size_t len)
     std::string result;
     size_t existBytes = readAbleBytes();
     if (len <= existBytes) {
-        result.assign(m_buffer.begin() + m_readPos, m_buffer.begin() + m_readPos + len);
+        result.assign(m_buffer + m_readPos, len);
         m_readPos += len;
     }
     return result;
@@ -94,35 +113,67 @@ std::string LinearBuffer::getDataByLength(size_t len)
 
 std::string LinearBuffer::justGetData()
 {
-    std::string result(m_buffer.begin() + m_readPos, m_buffer.begin() + m_writePos);
+    std::string result(m_buffer + m_readPos, readAbleBytes());
     return result;
 }
 
-void LinearBuffer::writeToBuffer(const char *str, size_t len)
+void LinearBuffer::release()
 {
-    size_t tailSpace = m_buffer.end() - m_buffer.begin() - m_writePos;
-    if (tailSpace < len) {
+    if (m_buffer == nullptr || readAbleBytes() > 0) return;
+    BufferPool::getInstance()->deallocate(m_buffer, m_capacity, m_sizeClass);
+    m_buffer = nullptr;
+    m_capacity = 0;
+    m_sizeClass = -1;
+    m_readPos = m_writePos = 0;
+}
+
+void LinearBuffer::shrinkToFit()
+{
+    size_t readable = readAbleBytes();
+    if (readable == 0) {
+        release();
+    } else if (m_capacity > m_initCapacity && readable * 4 <= m_capacity) {
+        expandSpace(readable);
+    }
+}
+
+void LinearBuffer::ensureWritable(size_t len)
+{
+    if (remainCapacity() >= len) return;
+    size_t readable = readAbleBytes();
+    // 前面已经取走的空间足够时只搬移数据，否则至少扩大一倍
+    if (m_buffer != nullptr && m_capacity - readable >= len) {
         moveTailToHead();
+    } else {
+        expandSpace(std::max(readable + len, m_capacity * 2));
     }
-    memcpy(m_buffer.data() + m_writePos, str, len);
-    m_writePos += len;
 }
 
 void LinearBuffer::expandSpace(size_t len)
 {
-    // 移动数据，扩大空间
-    moveTailToHead();
-    m_buffer.resize(len);
+    // 借用新的空间，搬移数据后归还原来的空间
+    size_t capacity;
+    int sizeClass;
+    char* buffer = BufferPool::getInstance()->allocate(std::max(len, m_initCapacity), capacity, sizeClass);
+    size_t lastUsage = readAbleBytes();
+    if (lastUsage > 0) {
+        memcpy(buffer, m_buffer + m_readPos, lastUsage);
+    }
+    BufferPool::getInstance()->deallocate(m_buffer, m_capacity, m_sizeClass);
+    m_buffer = buffer;
+    m_capacity = capacity;
+    m_sizeClass = sizeClass;
+    m_readPos = 0, m_writePos = lastUsage;
 }
 
 size_t LinearBuffer::remainCapacity() const
 {
-    return m_buffer.size() - m_writePos;
+    return m_capacity - m_writePos;
 }
 
 void LinearBuffer::moveTailToHead()
 {
     size_t lastUsage = m_writePos - m_readPos;
-    std::copy(m_buffer.begin() + m_readPos, m_buffer.begin() + m_writePos, m_buffer.begin());
+    memmove(m_buffer, m_buffer + m_readPos, lastUsage);
     m_readPos = 0, m_writePos = lastUsage;
 }
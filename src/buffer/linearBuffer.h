@@ -6,15 +6,28 @@
 #include <vector>
 #include <unistd.h>
 #include <sys/uio.h>
+#include "buffer/bufferPool.h"
+
+// 按之前的读入大小预留空间时，一次最多预留的空间
+#define LINEAR_READ_HINT_MAX (BUFFER_MIN_SIZE * 64)
 
 /*
 缓冲区不是线程安全的，
 使用左闭右开区间表示读写长度
+空间在第一次写入时才从BufferPool借用，release可以在没有数据时归还，空闲的连接不占用缓冲区
 */
 
 class LinearBuffer {
 public:
+    // capacity是第一次借用的大小
     LinearBuffer(size_t capacity = 4096);
+    ~LinearBuffer();
+
+    LinearBuffer(const LinearBuffer&) = delete;
+    LinearBuffer& operator=(const LinearBuffer&) = delete;
+
+    // 按之前观察到的读入大小预留空间，直接读进缓冲区，一次调用只复制一次
+    // 上一次读满了预留的空间时才用FIONREAD查询内核中剩下的字节数，读到EAGAIN的那一次只有一个系统调用
     ssize_t readFd(int fd, int* Errno);
     ssize_t writeFd(int fd, int* Errno);
     void append(const std::string& str);
@@ -24,16 +37,30 @@ public:
     std::string getReadAbleBytes();
     std::string getDataByLength(size_t len);
     std::string justGetData();
-    const char* readAddress() {return &m_buffer[m_readPos];}
-    void retrieveAll() {bzero(&m_buffer[0], m_buffer.size());m_readPos = m_writePos = 0;}
-    void retrieve(size_t len) {m_readPos += len;}
-    
+    const char* readAddress() {return m_buffer + m_readPos;}
+    // 只移动读写位置，不清零内存，和缓冲区曾经扩大到多大无关
+    void retrieveAll() {m_readPos = m_writePos = 0;}
+    // 数据全部取走后回到缓冲区头部，后续读入不需要搬移数据
+    void retrieve(size_t len) {m_readPos += len; if (m_readPos == m_writePos) m_readPos = m_writePos = 0;}
+    // 没有可读数据时把空间还给BufferPool，有数据时什么也不做
+    void release();
+    // 空闲时调用：没有数据时归还空间，数据不到容量的四分之一时换成能放下数据的小块
+    void shrinkToFit();
+    size_t capacity() const {return m_capacity;}
+
 private:
     size_t m_readPos;
     size_t m_writePos;
-    std::vector<char> m_buffer;
-    void writeToBuffer(const char* str, size_t len);
-    void expandSpace(size_t len);    // 表示m_buffer扩大到len
+    char* m_buffer;
+    size_t m_capacity;
+    int m_sizeClass;
+    size_t m_initCapacity;
+    // 下一次读入预留的大小
+    size_t m_readHint;
+    // 上一次读入填满了预留的空间，内核中可能还有更多数据
+    bool m_readFull;
+    void ensureWritable(size_t len);
+    void expandSpace(size_t len);    // 表示m_buffer换成能放下len的空间，也可以用来缩小
     size_t remainCapacity() const;
     void moveTailToHead();
 };
\ No newline at end of file
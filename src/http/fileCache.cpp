@@ -0,0 +1,157 @@
+#include "http/fileCache.h"
+#include <vector>
+#include "http/httpResponse.h"
+#include "log/log.h"
+
+CachedFile::~CachedFile()
+{
+    if (data_) {
+        munmap(data_, st.st_size);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+char* CachedFile::data() const
+{
+    std::call_once(mapOnce_, [this]() {
+        if (fd < 0 || st.st_size == 0) return;
+        void* ret = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ret == MAP_FAILED) {
+            LOG_ERROR("mmap file[%d] error!", fd);
+            return;
+        }
+        data_ = static_cast<char*>(ret);
+    });
+    return data_;
+}
+
+FileCache* FileCache::getInstance()
+{
+    static FileCache cache;
+    return &cache;
+}
+
+FileCache::FileCache(int ttlMS, size_t maxEntries): ttl_(ttlMS), maxEntries_(maxEntries)
+{}
+
+std::shared_ptr<const CachedFile> FileCache::get(const std::string& path)
+{
+    auto now = Clock::now();
+    {
+        std::shared_lock<std::shared_mutex> lock(mtx_);
+        auto it = files_.find(path);
+        if (it != files_.end() && now - it->second.checked < ttl_) {
+            return it->second.file;
+        }
+    }
+
+    // 未命中或者已经过期，重新stat，文件没有变化就继续使用原来的缓存项
+    struct stat st;
+    if (stat(path.data(), &st) < 0) {
+        std::unique_lock<std::shared_mutex> lock(mtx_);
+        auto it = files_.find(path);
+        if (it != files_.end()) {
+            Erase_(it);
+        }
+        return nullptr;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    auto it = files_.find(path);
+    if (it != files_.end()) {
+        const struct stat& old = it->second.file->st;
+        if (old.st_ino == st.st_ino && old.st_size == st.st_size && old.st_mode == st.st_mode &&
+            old.st_mtim.tv_sec == st.st_mtim.tv_sec && old.st_mtim.tv_nsec == st.st_mtim.tv_nsec) {
+            Touch_(it->second, now);
+            return it->second.file;
+        }
+    }
+
+    auto file = Open_(path, st);
+    if (!file->isDir() && file->readable() && file->fd < 0) {
+        if (it != files_.end()) {
+            Erase_(it);
+        }
+        return file;
+    }
+    if (it != files_.end()) {
+        it->second.file = file;
+        Touch_(it->second, now);
+        return file;
+    }
+    if (files_.size() >= maxEntries_) {
+        Evict_();
+    }
+    order_.push_back(path);
+    files_[path] = {file, now, std::prev(order_.end())};
+    return file;
+}
+
+void FileCache::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    files_.clear();
+    order_.clear();
+}
+
+std::string FileCache::Normalize(const std::string& path)
+{
+    std::vector<std::string> parts;
+    size_t i = 0;
+    while (i < path.size()) {
+        size_t j = path.find('/', i);
+        if (j == std::string::npos) j = path.size();
+        std::string part = path.substr(i, j - i);
+        if (part == "..") {
+            if (!parts.empty()) parts.pop_back();
+        } else if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+        i = j + 1;
+    }
+
+    std::string res;
+    for (auto& part : parts) {
+        res += "/" + part;
+    }
+    return res.empty() ? "/" : res;
+}
+
+std::shared_ptr<const CachedFile> FileCache::Open_(const std::string& path, const struct stat& st)
+{
+    auto file = std::make_shared<CachedFile>();
+    file->st = st;
+    // 目录和没有读权限的文件只缓存状态，由响应决定返回404或403
+    if (!file->isDir() && file->readable()) {
+        file->fd = open(path.data(), O_RDONLY | O_CLOEXEC);
+        if (file->fd < 0) {
+            LOG_ERROR("Open file %s error!", path.c_str());
+        }
+    }
+    file->mime = HttpResponse::GetFileType(path);
+    file->header = "Content-type: " + file->mime + "\r\n" +
+                   "Content-length: " + std::to_string(st.st_size) + "\r\n\r\n";
+    return file;
+}
+
+void FileCache::Touch_(Entry& entry, Clock::time_point now)
+{
+    entry.checked = now;
+    order_.splice(order_.end(), order_, entry.pos);
+}
+
+void FileCache::Erase_(std::unordered_map<std::string, Entry>::iterator it)
+{
+    order_.erase(it->second.pos);
+    files_.erase(it);
+}
+
+void FileCache::Evict_()
+{
+    // 链表头是最久没有检查的缓存项，有过期的缓存项时一定先淘汰过期的
+    if (!order_.empty()) {
+        Erase_(files_.find(order_.front()));
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <chrono>
+#include <list>
+#include <unordered_map>
+
+/*
+静态资源的打开文件缓存，所有连接共享
+缓存文件的fd、文件状态、MIME类型和预先拼好的Content-type/Content-length头部
+命中时不需要任何文件系统调用，超过TTL之后重新stat一次，文件被修改时重新打开
+缓存项按最近一次检查的时间排成链表，满了之后淘汰最久没有检查的一项，命中不需要修改链表
+存在但是打不开的文件不缓存，下一次请求重新打开
+响应持有shared_ptr，缓存项被替换或淘汰后，正在发送的响应仍然可以安全使用旧的fd和映射
+*/
+struct CachedFile {
+    int fd = -1;
+    struct stat st = {};
+    std::string mime;
+    std::string header;     // Content-type和Content-length，以空行结尾
+
+    CachedFile() = default;
+    ~CachedFile();
+    CachedFile(const CachedFile&) = delete;
+    CachedFile& operator=(const CachedFile&) = delete;
+
+    bool isDir() const { return S_ISDIR(st.st_mode); }
+    bool readable() const { return st.st_mode & S_IROTH; }
+    size_t size() const { return st.st_size; }
+    // 第一次使用时才映射，sendfile模式下文件不会被映射
+    char* data() const;
+
+private:
+    mutable std::once_flag mapOnce_;
+    mutable char* data_ = nullptr;
+};
+
+class FileCache {
+public:
+    static FileCache* getInstance();
+
+    // 文件不存在时返回nullptr
+    std::shared_ptr<const CachedFile> get(const std::string& path);
+    void setTTL(int ttlMS) { ttl_ = std::chrono::milliseconds(ttlMS); }
+    void setMaxEntries(size_t maxEntries) { maxEntries_ = maxEntries; }
+    void clear();
+
+    // 去掉重复的'/'和'.'，'..'不能越过根目录
+    static std::string Normalize(const std::string& path);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry {
+        std::shared_ptr<const CachedFile> file;
+        Clock::time_point checked;
+        // 在order_中的位置
+        std::list<std::string>::iterator pos;
+    };
+
+    FileCache(int ttlMS = 2000, size_t maxEntries = 1024);
+    ~FileCache() = default;
+    FileCache(const FileCache&) = delete;
+    FileCache& operator=(const FileCache&) = delete;
+
+    std::shared_ptr<const CachedFile> Open_(const std::string& path, const struct stat& st);
+    // 以下函数需要持有写锁
+    void Touch_(Entry& entry, Clock::time_point now);
+    void Erase_(std::unordered_map<std::string, Entry>::iterator it);
+    void Evict_();
+
+    std::shared_mutex mtx_;
+    std::unordered_map<std::string, Entry> files_;
+    // 按检查时间从早到晚排列的路径，过期的缓存项都在前面
+    std::list<std::string> order_;
+    std::chrono::milliseconds ttl_;
+    size_t maxEntries_;
+};
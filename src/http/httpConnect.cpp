@@ -1,17 +1,21 @@
 #include "http/httpConnect.h"
 #include <cstring>
+#include <limits.h>
+#include <algorithm>
 
 const char* HttpConnect::m_srcDir;
+bool HttpConnect::m_sendFile = false;
 
-HttpConnect::HttpConnect(MySQLConnectionPool* mysql, RedisConnectionPool* redis)
+HttpConnect::HttpConnect(MySQLConnectionPool* mysql, RedisConnectionPool* redis): m_request(mysql, redis)
 {
     assert(mysql != nullptr);
     assert(redis != nullptr);
 
     m_fd = -1;
     m_isClosed = false;
-    m_request = new HttpRequest(mysql, redis);
-    m_response = new HttpResponse();
+    m_keepAlive = false;
+    m_inFlight = 0;
+    m_closing = false;
 }
 
 void HttpConnect::init(int fd, const sockaddr_in &addr)
@@ -19,6 +23,7 @@ void HttpConnect::init(int fd, const sockaddr_in &addr)
     m_fd = fd;
     m_addr = addr;
     m_isClosed = false;
+    m_closing = false;
 }
 
 ssize_t HttpConnect::read(int *Errno)
@@ -33,73 +38,56 @@ ssize_t HttpConnect::read(int *Errno)
     return readBytes;
 }
 
+// 整条响应链一次sendmsg发送，遇到sendfile的文件时带MSG_MORE，发送完文件后继续发送后面的响应
 ssize_t HttpConnect::write(int *Errno)
 {
-    ssize_t len = -1;
+    return m_writeBuffer.writeFd(m_fd, Errno);
+}
 
-    while (true) {
-        len = writev(m_fd, m_iov, m_iovCnt);
-        if (len <= 0) {
-            *Errno = errno;
+bool HttpConnect::process()
+{
+    size_t count = 0;
+    m_writeBuffer.clear();
+    while (count < MAX_PIPELINE && m_readBuffer.readAbleBytes() > 0) {
+        HttpParser::RESULT ret = m_request.parse(m_readBuffer);
+        // 请求还没有收全，继续等待读事件
+        if(ret == HttpParser::INCOMPLETE) {
             break;
         }
-        
-        if(m_iov[0].iov_len + m_iov[1].iov_len  == 0) {
-            break;
-        } else if(static_cast<size_t>(len) > m_iov[0].iov_len) {
-            m_iov[1].iov_base = (uint8_t*) m_iov[1].iov_base + (len - m_iov[0].iov_len);
-            m_iov[1].iov_len -= (len - m_iov[0].iov_len);
-            if(m_iov[0].iov_len) {
-                m_writeBuffer.retrieveAll();
-                m_iov[0].iov_len = 0;
-            }
+        else if(ret == HttpParser::COMPLETE) {
+            LOG_DEBUG("Request content is %s", m_request.path().c_str());
+            m_response.Init(m_srcDir, m_request.path(), m_request.IsKeepAlive(), 200, m_sendFile);
         } else {
-            m_iov[0].iov_base = (uint8_t*)m_iov[0].iov_base + len; 
-            m_iov[0].iov_len -= len; 
-            m_writeBuffer.retrieve(len);
+            m_response.Init(m_srcDir, m_request.path(), false, 400, m_sendFile);
         }
-    }
-
-    return len;
-}
+        m_keepAlive = ret == HttpParser::COMPLETE && m_request.IsKeepAlive();
 
-bool HttpConnect::process()
-{
-    m_request->Init();
-    if(m_readBuffer.readAbleBytes() <= 0) {
-        return false;
-    }
-    else if(m_request->parse(m_readBuffer)) {
-        LOG_DEBUG("Request content is %s", m_request->path().c_str());
-        m_response->Init(m_srcDir, m_request->path(), m_request->IsKeepAlive(), 200);
-    } else {
-        m_response->Init(m_srcDir, m_request->path(), false, 400);
-    }
-    
-    m_response->MakeResponse(m_writeBuffer);
+        size_t before = m_writeBuffer.readAbleBytes();
+        m_response.MakeResponse(m_writeBuffer);
+        ++ count;
+        LOG_DEBUG("filesize:%zu, %zu bytes to write", m_response.FileLen(), m_writeBuffer.readAbleBytes() - before);
 
-    m_iov[0].iov_base = const_cast<char*>(m_writeBuffer.readAddress());
-    m_iov[0].iov_len = m_writeBuffer.readAbleBytes();
-    m_iovCnt = 1;
-
-    // 文件
-    if(m_response->FileLen() > 0  && m_response->File()) {
-        m_iov[1].iov_base = m_response->File();
-        m_iov[1].iov_len = m_response->FileLen();
-        m_iovCnt = 2;
+        // 连接将要关闭时后面的请求也不再处理
+        if(!m_keepAlive) {
+            break;
+        }
     }
-    LOG_DEBUG("filesize:%d, %d to %d", m_response->FileLen() , m_iovCnt, toWriteBytes());
-    return true;
+    // 读缓冲区中的请求都已经处理完，连接空闲时不占用读缓冲区
+    // 还剩半个请求时，大请求留下的大块也换成小块
+    m_readBuffer.shrinkToFit();
+    return count > 0;
 }
+
 void HttpConnect::clearResource()
 {
     m_fd = -1;
-    m_request->Init();
+    m_request.Init();
 }
 
 void HttpConnect::closeClient()
 {
-    m_response->UnmapFile();
+    m_response.ReleaseFile();
+    m_writeBuffer.clear();
     m_isClosed = true;
     close(m_fd);
     LOG_INFO("Client [%d] quit", m_fd);
@@ -1,9 +1,18 @@
 #pragma once
 #include <netinet/in.h>
+#include <sys/socket.h>
+#include <atomic>
 #include "log/log.h"
 #include "buffer/linearBuffer.h"
+#include "buffer/chainBuffer.h"
 #include "http/httpRequest.h"
 #include "http/httpResponse.h"
+#include "timer/timingWheel.h"
+
+// 一次处理的流水线请求数量上限，剩下的请求在响应发送完后继续处理
+#define MAX_PIPELINE 16
+// m_inFlight中标记连接交还之后关闭的位，和任务数在同一个原子变量里，标记和交还不会错过对方
+#define INFLIGHT_CLOSE_PENDING (1 << 30)
 
 class HttpConnect {
 public:
@@ -15,27 +24,41 @@ public:
 
     ssize_t read(int* Errno);
     ssize_t write(int* Errno);
+    // 完成模式下数据由内核收到注册的缓冲区中，再复制进读缓冲区；写缓冲区由事件循环提交给内核发送
+    void received(const char* data, size_t len) {m_readBuffer.append(data, len);}
+    ChainBuffer& writeBuffer() {return m_writeBuffer;}
+    // 处理读缓冲区中所有完整的请求（HTTP/1.1流水线），响应按顺序追加到写缓冲区的链上
     bool process();
 
-    bool isKeepAlive() const {return m_request->IsKeepAlive();}
-    int toWriteBytes() {return m_iov[0].iov_len + m_iov[1].iov_len;}
+    bool isKeepAlive() const {return m_keepAlive;}
+    size_t toWriteBytes() const {return m_writeBuffer.readAbleBytes();}
 
     void clearResource();
     void closeClient();
 
     static const char* m_srcDir;
+    // 使用sendfile发送静态文件，文件不再映射到进程中
+    static bool m_sendFile;
     bool m_isClosed;
+    // 空闲超时定时器，由连接所属的EventLoop使用
+    WheelNode m_timerNode;
+    // 交给线程池还没有交还的任务数，大于0时事件循环不能关闭连接
+    // INFLIGHT_CLOSE_PENDING位表示事件循环要求关闭，最后交还连接的任务负责请求关闭
+    // 完成模式下是还没有完成的发送请求数
+    std::atomic<int> m_inFlight;
+    // 完成模式下等待发送请求被取消之后关闭
+    bool m_closing;
 
 private:
     int m_fd;
     sockaddr_in m_addr;
-    iovec m_iov[2];
-    size_t m_iovCnt;
+    bool m_keepAlive;
 
-    std::vector<char> m_tempBuff;
+    // 缓冲区只在有数据收发时占用空间，请求处理完、响应发送完之后归还给BufferPool
     LinearBuffer m_readBuffer;
-    LinearBuffer m_writeBuffer;
+    // 待发送的响应链，持有文件内容和缓存响应的引用
+    ChainBuffer m_writeBuffer;
 
-    HttpRequest* m_request;
-    HttpResponse* m_response;
+    HttpRequest m_request;
+    HttpResponse m_response;
 };
\ No newline at end of file
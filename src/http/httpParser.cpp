@@ -0,0 +1,168 @@
+#include "http/httpParser.h"
+#include <string.h>
+#include "util/scan.h"
+
+void HttpParser::reset()
+{
+    m_base = nullptr;
+    m_state = REQUEST_LINE;
+    m_pos = m_scan = 0;
+    m_method = m_path = m_version = m_body = {0, 0};
+    m_headerCount = 0;
+    m_hasConnection = false;
+    m_keepAlive = false;
+    m_contentLength = 0;
+}
+
+HttpParser::RESULT HttpParser::parse(const char* data, size_t len)
+{
+    m_base = data;
+    while (m_state == REQUEST_LINE || m_state == HEADERS) {
+        // 一次扫描同时找到行尾和非法的控制字符
+        const char* last = data + len;
+        const char* p = scan::findCtl(data + m_scan, last);
+        if (p == last || (*p == '\r' && p + 1 == last)) {
+            // 行还没有收全，下次从这里继续扫描
+            m_scan = p - data;
+            if (len > HTTP_MAX_HEADER_SIZE) {
+                m_state = ERROR;
+                return BAD;
+            }
+            return INCOMPLETE;
+        }
+        size_t end = p - data;
+        size_t next;
+        if (*p == '\n') {
+            next = end + 1;
+        } else if (*p == '\r' && p[1] == '\n') {
+            next = end + 2;
+        } else {
+            m_state = ERROR;
+            return BAD;
+        }
+        size_t begin = m_pos;
+        m_pos = m_scan = next;
+
+        if (m_state == REQUEST_LINE) {
+            // 允许请求之间有多余的空行
+            if (end == begin) continue;
+            if (!parseRequestLine(begin, end)) {
+                m_state = ERROR;
+                return BAD;
+            }
+            m_state = HEADERS;
+        } else if (end == begin) {
+            if (!finishHeaders()) {
+                m_state = ERROR;
+                return BAD;
+            }
+        } else if (!parseHeader(begin, end)) {
+            m_state = ERROR;
+            return BAD;
+        }
+    }
+
+    if (m_state == BODY) {
+        if (len - m_pos < m_contentLength) {
+            return INCOMPLETE;
+        }
+        m_body = {static_cast<uint32_t>(m_pos), static_cast<uint32_t>(m_contentLength)};
+        m_pos += m_contentLength;
+        m_state = FINISH;
+    }
+    return m_state == FINISH ? COMPLETE : BAD;
+}
+
+// 请求行：方法 路径 HTTP/版本
+bool HttpParser::parseRequestLine(size_t begin, size_t end)
+{
+    const char* line = m_base + begin;
+    size_t len = end - begin;
+
+    const char* sp1 = scan::findNonToken(line, line + len);
+    if (sp1 == line || sp1 == line + len || *sp1 != ' ') return false;
+    const char* target = sp1 + 1;
+    const char* sp2 = static_cast<const char*>(memchr(target, ' ', line + len - target));
+    if (!sp2 || sp2 == target) return false;
+    const char* ver = sp2 + 1;
+    size_t verLen = line + len - ver;
+    if (verLen <= 5 || memcmp(ver, "HTTP/", 5) != 0) return false;
+
+    m_method = {static_cast<uint32_t>(begin), static_cast<uint32_t>(sp1 - line)};
+    m_path = {static_cast<uint32_t>(target - m_base), static_cast<uint32_t>(sp2 - target)};
+    m_version = {static_cast<uint32_t>(ver + 5 - m_base), static_cast<uint32_t>(verLen - 5)};
+    return view(m_version).find(' ') == std::string_view::npos;
+}
+
+// 请求头：名字: 值，值两端的空白不属于值
+bool HttpParser::parseHeader(size_t begin, size_t end)
+{
+    const char* line = m_base + begin;
+    size_t len = end - begin;
+    // 头部名称必须是token，紧跟冒号
+    const char* colon = scan::findNonToken(line, line + len);
+    if (colon == line || colon == line + len || *colon != ':' || m_headerCount == HTTP_MAX_HEADERS) return false;
+
+    const char* value = colon + 1;
+    const char* valueEnd = line + len;
+    while (value < valueEnd && (*value == ' ' || *value == '\t')) ++ value;
+    while (valueEnd > value && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t')) -- valueEnd;
+
+    Header& h = m_headers[m_headerCount ++];
+    h.name = {static_cast<uint32_t>(begin), static_cast<uint32_t>(colon - line)};
+    h.value = {static_cast<uint32_t>(value - m_base), static_cast<uint32_t>(valueEnd - value)};
+
+    std::string_view name = view(h.name);
+    std::string_view val = view(h.value);
+    if (iequals(name, "Connection")) {
+        m_hasConnection = true;
+        m_keepAlive = iequals(val, "keep-alive");
+    } else if (iequals(name, "Content-Length")) {
+        if (val.empty()) return false;
+        size_t n = 0;
+        for (char c : val) {
+            if (c < '0' || c > '9') return false;
+            n = n * 10 + (c - '0');
+            if (n > HTTP_MAX_BODY_SIZE) return false;
+        }
+        m_contentLength = n;
+    }
+    return true;
+}
+
+// 头部结束时确定是否保持连接：HTTP/1.1默认保持，除非指定close；HTTP/1.0需要显式指定keep-alive
+bool HttpParser::finishHeaders()
+{
+    std::string_view ver = view(m_version);
+    if (ver == "1.1") {
+        m_keepAlive = !m_hasConnection || !iequals(header("Connection"), "close");
+    } else if (ver != "1.0") {
+        return false;
+    }
+    m_state = m_contentLength > 0 ? BODY : FINISH;
+    return true;
+}
+
+std::string_view HttpParser::header(std::string_view name) const
+{
+    for (size_t i = 0; i < m_headerCount; ++ i) {
+        if (iequals(view(m_headers[i].name), name)) {
+            return view(m_headers[i].value);
+        }
+    }
+    return std::string_view();
+}
+
+static inline char lower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+bool HttpParser::iequals(std::string_view a, std::string_view b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++ i) {
+        if (lower(a[i]) != lower(b[i])) return false;
+    }
+    return true;
+}
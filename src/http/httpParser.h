@@ -0,0 +1,85 @@
+#pragma once
+#include <string_view>
+#include <stddef.h>
+#include <stdint.h>
+
+#define HTTP_MAX_HEADERS 32
+#define HTTP_MAX_HEADER_SIZE 8192
+#define HTTP_MAX_BODY_SIZE (1024 * 1024)
+
+/*
+HTTP/1.1请求的增量解析器，不分配内存也不拷贝数据
+解析结果只保存相对请求起始位置的偏移，读缓冲区扩容或搬移之后仍然有效，
+数据没有收全时返回INCOMPLETE，收到更多数据后从上次停下的位置继续解析
+请求头保存在固定大小的数组中，Connection和Content-Length在解析头部时就计算好
+*/
+class HttpParser {
+public:
+    enum STATE {
+        REQUEST_LINE,
+        HEADERS,
+        BODY,
+        FINISH,
+        ERROR,
+    };
+
+    enum RESULT {
+        COMPLETE,
+        INCOMPLETE,
+        BAD,
+    };
+
+    HttpParser() { reset(); }
+
+    void reset();
+    // data指向请求的第一个字节，每次传入目前收到的全部数据
+    RESULT parse(const char* data, size_t len);
+
+    STATE state() const { return m_state; }
+    // 完整请求（包括请求体）的字节数
+    size_t consumed() const { return m_pos; }
+
+    // 以下视图指向最近一次parse传入的数据，数据被取走之后失效
+    std::string_view method() const { return view(m_method); }
+    std::string_view path() const { return view(m_path); }
+    std::string_view version() const { return view(m_version); }
+    std::string_view body() const { return view(m_body); }
+    size_t headerCount() const { return m_headerCount; }
+    std::string_view headerName(size_t i) const { return view(m_headers[i].name); }
+    std::string_view headerValue(size_t i) const { return view(m_headers[i].value); }
+    // 名字不区分大小写，不存在时返回空
+    std::string_view header(std::string_view name) const;
+
+    bool keepAlive() const { return m_keepAlive; }
+    size_t contentLength() const { return m_contentLength; }
+
+    static bool iequals(std::string_view a, std::string_view b);
+
+private:
+    struct Span {
+        uint32_t off;
+        uint32_t len;
+    };
+    struct Header {
+        Span name;
+        Span value;
+    };
+
+    const char* m_base;
+    STATE m_state;
+    // 下一行的起始位置和换行符的查找位置
+    size_t m_pos;
+    size_t m_scan;
+
+    Span m_method, m_path, m_version, m_body;
+    Header m_headers[HTTP_MAX_HEADERS];
+    size_t m_headerCount;
+    bool m_hasConnection;
+    bool m_keepAlive;
+    size_t m_contentLength;
+
+    bool parseRequestLine(size_t begin, size_t end);
+    bool parseHeader(size_t begin, size_t end);
+    bool finishHeaders();
+    std::string_view view(Span s) const { return std::string_view(m_base + s.off, s.len); }
+};
@@ -3,9 +3,6 @@
 
 using namespace std;
 
-// 在解析错误的时候定位bug
-std::string checkData;
-
 const unordered_set<string> HttpRequest::DEFAULT_HTML {
     "/index", "/register", "/login", "/welcome", "/video", "/picture",
 };
@@ -21,71 +18,50 @@ HttpRequest::HttpRequest(MySQLConnectionPool* mysql, RedisConnectionPool* redis)
     assert(redis != nullptr);
     m_mysql = mysql;
     m_redis = redis;
+    Init();
 }
 
 void HttpRequest::Init() {
-    state_ = REQUEST_LINE;
-    method_ = path_ = version_= body_ = "";
-    header_.clear();
+    parser_.reset();
+    method_.clear();
+    path_.clear();
+    version_.clear();
+    body_.clear();
+    isKeepAlive_ = false;
     post_.clear();
 }
 
-bool HttpRequest::parse(LinearBuffer& buff) {
-    std::string END = "\r\n";
-    if(buff.readAbleBytes() == 0)
-        return false;
-    checkData = buff.justGetData();
-
-    while(buff.readAbleBytes() && state_ != FINISH) {
-        int *Errno = 0;
-        string line;
-        // 请求体的后面部分并没有结束符号
-        if (state_ == BODY) {
-            line  = buff.getDataByLength(stoi(header_["Content-Length"]));
-        } else {
-            line = buff.getByEndFlag(END);
-        }
-        
-        switch (state_)
-        {
-        case REQUEST_LINE:
-            if(!ParseRequestLine_(line)) {
-                return false;
-            }
-            ParsePath_();
-            break;
-        case HEADERS:
-            ParseHeader_(line);
-            if(buff.readAbleBytes() <= 2) {
-                state_ = FINISH;
-                buff.getReadAbleBytes();
-            }
-            break;
-        case BODY:
-            ParseBody_(line);
-            break;
-        default:
-            break;
-        }
+HttpParser::RESULT HttpRequest::parse(LinearBuffer& buff) {
+    // 上一个请求已经处理完，开始解析新的请求
+    if(parser_.state() == HttpParser::FINISH || parser_.state() == HttpParser::ERROR) {
+        Init();
+    }
+    if(buff.readAbleBytes() == 0) {
+        return HttpParser::INCOMPLETE;
+    }
 
+    HttpParser::RESULT ret = parser_.parse(buff.readAddress(), buff.readAbleBytes());
+    if(ret == HttpParser::INCOMPLETE) {
+        return ret;
+    }
+    if(ret == HttpParser::BAD) {
+        LOG_ERROR("Request parse error, %zu bytes", buff.readAbleBytes());
+        buff.retrieveAll();
+        return ret;
     }
-    checkData = "";
-    LOG_DEBUG("[%s], [%s], [%s]", method_.c_str(), path_.c_str(), version_.c_str());
-    return true;
-}
 
-bool HttpRequest::ParseRequestLine_(const string& line) {
-    regex patten("^([^ ]*) ([^ ]*) HTTP/([^ ]*)$");
-    smatch Match;
-    if(regex_match(line, Match, patten)) {
-        method_ = Match[1];
-        path_ = Match[2];
-        version_ = Match[3];
-        state_ = HEADERS;
-        return true;
+    method_.assign(parser_.method());
+    path_.assign(parser_.path());
+    version_.assign(parser_.version());
+    isKeepAlive_ = parser_.keepAlive();
+    ParsePath_();
+    if(method_ == "POST") {
+        body_.assign(parser_.body());
+        ParsePost_(parser_.header("Content-Type"));
     }
-    LOG_ERROR("RequestLine Error, Error meesage is: %s", checkData);
-    return false;
+    buff.retrieve(parser_.consumed());
+    LOG_DEBUG("[%s], [%s], [%s]", method_.c_str(), path_.c_str(), version_.c_str());
+    return ret;
 }
 
 void HttpRequest::ParsePath_() {
@@ -98,25 +74,8 @@ void HttpRequest::ParsePath_() {
     }
 }
 
-void HttpRequest::ParseHeader_(const string& line) {
-    regex patten("^([^:]*): ?(.*)$");
-    smatch Match;
-    if(regex_match(line, Match, patten)) {
-        header_[Match[1]] = Match[2];
-    } else {
-        state_ = BODY;
-    }
-}
-
-void HttpRequest::ParseBody_(const string& line) {
-    body_ = line;
-    ParsePost_();
-    state_ = FINISH;
-    LOG_DEBUG("Body:%s, len:%d", line.c_str(), line.size());
-}
-
-void HttpRequest::ParsePost_() {
-    if(method_ == "POST" && header_["Content-Type"] == "application/x-www-form-urlencoded") {
+void HttpRequest::ParsePost_(std::string_view contentType) {
+    if(contentType == "application/x-www-form-urlencoded") {
         ParseFromUrlencoded_();
         if(DEFAULT_HTML_TAG.count(path_)) {
             int tag = DEFAULT_HTML_TAG.find(path_)->second; 
@@ -315,8 +274,5 @@ std::string HttpRequest::GetPost(const char* key) const {
 
 // 来检查是否要求保持连接（长连接）
 bool HttpRequest::IsKeepAlive() const {
-    if(header_.count("Connection") == 1) {
-        return header_.find("Connection")->second == "keep-alive" && version_ == "1.1";
-    }
-    return false;
+    return isKeepAlive_;
 }
\ No newline at end of file
@@ -1,25 +1,19 @@
 #pragma once
 #include <unordered_map>
 #include <unordered_set>
-#include <regex>
 #include "buffer/buffer.h"
+#include "http/httpParser.h"
 #include "log/log.h"
 #include "pool/connectPool.h"
 
 class HttpRequest {
 public:
-    enum PARSE_STATE {
-        REQUEST_LINE,
-        HEADERS,
-        BODY,
-        FINISH,        
-    };
-
     HttpRequest(MySQLConnectionPool* mysql, RedisConnectionPool* redis);
     ~HttpRequest() = default;
 
     void Init();
-    bool parse(LinearBuffer& buff);
+    // 请求完整时从缓冲区中取走这个请求，不完整时保留数据，等到收到更多数据后继续解析
+    HttpParser::RESULT parse(LinearBuffer& buff);
 
     std::string path() const;
     std::string& path();
@@ -30,9 +24,9 @@ public:
     bool IsKeepAlive() const;
 
 private:
-    PARSE_STATE state_;
+    HttpParser parser_;
     std::string method_, path_, version_, body_;
-    std::unordered_map<std::string, std::string> header_;
+    bool isKeepAlive_;
     std::unordered_map<std::string, std::string> post_;
     static const std::unordered_set<std::string> DEFAULT_HTML;
     static const std::unordered_map<std::string, int> DEFAULT_HTML_TAG;
@@ -40,12 +34,8 @@ private:
     MySQLConnectionPool* m_mysql;
     RedisConnectionPool* m_redis;
 
-    bool ParseRequestLine_(const std::string& line);    // 处理请求行
-    void ParseHeader_(const std::string& line);         // 处理请求头
-    void ParseBody_(const std::string& line);           // 处理请求体
-
     void ParsePath_();                                  // 处理请求路径
-    void ParsePost_();                                  // 处理Post事件
+    void ParsePost_(std::string_view contentType);      // 处理Post事件
     void ParseFromUrlencoded_();                        // 从url种解析编码
 
     bool UserVerify(const std::string& name, const std::string& pwd, bool isLogin);  // 用户验证
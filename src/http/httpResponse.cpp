@@ -1,4 +1,5 @@
 #include "http/httpResponse.h"
+#include "timer/cachedClock.h"
 
 const std::unordered_map<std::string, std::string> HttpResponse::SUFFIX_TYPE = {
     { ".html",  "text/html" },
@@ -27,6 +28,15 @@ const std::unordered_map<int, std::string> HttpResponse::CODE_STATUS = {
     { 400, "Bad Request" },
     { 403, "Forbidden" },
     { 404, "Not Found" },
+    { 500, "Internal Server Error" },
+};
+
+const std::unordered_map<int, std::string> HttpResponse::STATE_LINE = {
+    { 200, "HTTP/1.1 200 OK\r\n" },
+    { 400, "HTTP/1.1 400 Bad Request\r\n" },
+    { 403, "HTTP/1.1 403 Forbidden\r\n" },
+    { 404, "HTTP/1.1 404 Not Found\r\n" },
+    { 500, "HTTP/1.1 500 Internal Server Error\r\n" },
 };
 
 const std::unordered_map<int, std::string> HttpResponse::CODE_PATH = {
@@ -39,121 +49,169 @@ HttpResponse::HttpResponse() {
     code_ = -1;
     path_ = srcDir_ = "";
     isKeepAlive_ = false;
-    mmFile_ = nullptr; 
-    mmFileStat_ = { 0 };
+    sendFile_ = false;
+    blockStateLen_ = 0;
 };
 
 HttpResponse::~HttpResponse() {
-    UnmapFile();
+    ReleaseFile();
 }
 
-void HttpResponse::Init(const std::string& srcDir, std::string& path, bool isKeepAlive, int code){
+void HttpResponse::Init(const std::string& srcDir, std::string& path, bool isKeepAlive, int code, bool sendFile){
     assert(this != nullptr);
     assert(srcDir != "");
-    if(mmFile_) { UnmapFile(); }
+    ReleaseFile();
     code_ = code;
     isKeepAlive_ = isKeepAlive;
+    sendFile_ = sendFile;
     path_ = path;
     srcDir_ = srcDir;
-    mmFile_ = nullptr; 
-    mmFileStat_ = { 0 };
 }
 
-void HttpResponse::MakeResponse(LinearBuffer& buff) {
-    if(stat((srcDir_ + path_).data(), &mmFileStat_) < 0 || S_ISDIR(mmFileStat_.st_mode)) {
-        code_ = 404;
+void HttpResponse::MakeResponse(ChainBuffer& buff) {
+    // 请求本身有错误时直接返回错误页面
+    if(code_ < 400) {
+        path_ = FileCache::Normalize(path_);
+        file_ = FileCache::getInstance()->get(srcDir_ + path_);
+        if(!file_ || file_->isDir()) {
+            code_ = 404;
+        }
+        else if(!file_->readable()) {
+            code_ = 403;
+        }
+        else if(file_->fd < 0) {
+            // 文件存在但是打不开，没有错误页面，由AddContent_生成响应体
+            code_ = 500;
+        }
+        else if(code_ == -1) { 
+            code_ = 200; 
+        }
     }
-    else if(!(mmFileStat_.st_mode & S_IROTH)) {
-        code_ = 403;
+    ErrorHtml_();
+    if(CachedResponse_()) {
+        buff.appendRef(block_->data(), blockStateLen_, block_);
+        AddDate_(buff);
+        buff.appendRef(block_->data() + blockStateLen_, block_->size() - blockStateLen_, block_);
+        return;
     }
-    else if(code_ == -1) { 
-        code_ = 200; 
+    // 映射失败时不能发送文件内容，在写出状态行之前改成错误响应
+    if(file_ && !sendFile_ && file_->size() > 0 && !file_->data()) {
+        ReleaseFile();
+        code_ = 500;
     }
-    ErrorHtml_();
     AddStateLine_(buff);
+    AddDate_(buff);
     AddHeader_(buff);
     AddContent_(buff);
 }
 
-char* HttpResponse::File() {
-    return mmFile_;
-}
-
 size_t HttpResponse::FileLen() const {
-    return mmFileStat_.st_size;
+    return file_ ? file_->size() : 0;
 }
 
 void HttpResponse::ErrorHtml_() {
     if(CODE_PATH.count(code_) == 1) {
         path_ = CODE_PATH.find(code_)->second;
-        stat((srcDir_ + path_).data(), &mmFileStat_);
+        file_ = FileCache::getInstance()->get(srcDir_ + path_);
     }
 }
 
-void HttpResponse::AddStateLine_(LinearBuffer& buff) {
-    std::string status;
-    if(CODE_STATUS.count(code_) == 1) {
-        status = CODE_STATUS.find(code_)->second;
-    }
-    else {
+void HttpResponse::AddStateLine_(ChainBuffer& buff) {
+    if(STATE_LINE.count(code_) == 0) {
         code_ = 400;
-        status = CODE_STATUS.find(400)->second;
     }
-    buff.append("HTTP/1.1 " + std::to_string(code_) + " " + status + "\r\n");
+    const std::string& line = STATE_LINE.find(code_)->second;
+    buff.appendStatic(line.data(), line.size());
+}
+
+// 事件循环每秒格式化一次
+void HttpResponse::AddDate_(ChainBuffer& buff) {
+    buff.append(CachedClock::dateHeader(), CachedClock::dateHeaderLen());
 }
 
-void HttpResponse::AddHeader_(LinearBuffer& buff) {
-    buff.append("Connection: ");
+void HttpResponse::AddHeader_(ChainBuffer& buff) {
+    static const char keepAlive[] = "Connection: keep-alive\r\nkeep-alive: max=6, timeout=120\r\n";
+    static const char closeHeader[] = "Connection: close\r\n";
     if(isKeepAlive_) {
-        buff.append("keep-alive\r\n");
-        buff.append("keep-alive: max=6, timeout=120\r\n");
+        buff.appendStatic(keepAlive, sizeof(keepAlive) - 1);
     } else{
-        buff.append("close\r\n");
+        buff.appendStatic(closeHeader, sizeof(closeHeader) - 1);
     }
-    buff.append("Content-type: " + GetFileType_() + "\r\n");
 }
 
-void HttpResponse::AddContent_(LinearBuffer& buff) {
-    int srcFd = open((srcDir_ + path_).data(), O_RDONLY);
-    if(srcFd < 0) { 
-        ErrorContent(buff, "File NotFound!");
+// 文件缓存中已经拼好了Content-type和Content-length
+void HttpResponse::AddContent_(ChainBuffer& buff) {
+    // 状态码已经在MakeResponse中改成错误码
+    if(!file_ || file_->fd < 0) {
+        ReleaseFile();
+        ErrorContent(buff, code_ == 500 ? "File can not be read!" : "File NotFound!");
         return; 
     }
-
-    // 将文件映射到内存提高文件的访问速度  MAP_PRIVATE 建立一个写入时拷贝的私有映射
-    // mmap
     LOG_DEBUG("file path %s", (srcDir_ + path_).data());
-    int* mmRet = (int*)mmap(0, mmFileStat_.st_size, PROT_READ, MAP_PRIVATE, srcFd, 0);
-    if(*mmRet == -1) {
-        ErrorContent(buff, "File NotFound!");
-        return; 
+    buff.appendRef(file_->header.data(), file_->header.size(), file_);
+    if(sendFile_) {
+        buff.appendFile(file_->fd, 0, file_->size(), file_);
+    } else {
+        buff.appendRef(file_->data(), file_->size(), file_);
     }
-    mmFile_ = (char*)mmRet;
-    close(srcFd);
-    buff.append("Content-length: " + std::to_string(mmFileStat_.st_size) + "\r\n\r\n");
 }
 
-void HttpResponse::UnmapFile() {
-    if(mmFile_) {
-        munmap(mmFile_, mmFileStat_.st_size);
-        mmFile_ = nullptr;
+void HttpResponse::ReleaseFile() {
+    file_.reset();
+    block_.reset();
+    blockStateLen_ = 0;
+}
+
+// 小文件使用缓存的完整响应，未命中时生成一份放入缓存
+bool HttpResponse::CachedResponse_() {
+    ResponseCache* cache = ResponseCache::getInstance();
+    if(!file_ || file_->fd < 0 || !cache->cacheable(file_->size())) {
+        return false;
+    }
+    std::string key = std::to_string(code_) + (isKeepAlive_ ? "k" : "c") + path_;
+    block_ = cache->get(key, file_);
+    if(!block_) {
+        // 缓存中不包含Date头
+        ChainBuffer head;
+        AddStateLine_(head);
+        AddHeader_(head);
+        head.appendStatic(file_->header.data(), file_->header.size());
+
+        auto block = std::make_shared<std::string>(head.toString());
+        size_t headLen = block->size();
+        block->resize(headLen + file_->size());
+        size_t done = 0;
+        while(done < file_->size()) {
+            ssize_t len = pread(file_->fd, &(*block)[headLen + done], file_->size() - done, done);
+            if(len <= 0) {
+                // 文件被截断，按原来的方式处理
+                LOG_WARN("Read file %s error!", path_.data());
+                return false;
+            }
+            done += len;
+        }
+        cache->put(key, file_, block);
+        block_ = std::move(block);
     }
+    blockStateLen_ = block_->find("\r\n") + 2;
+    file_.reset();
+    return true;
 }
 
 // 判断文件类型 
-std::string HttpResponse::GetFileType_() {
-    std::string::size_type idx = path_.find_last_of('.');
+std::string HttpResponse::GetFileType(const std::string& path) {
+    std::string::size_type idx = path.find_last_of('.');
     if(idx == std::string::npos) {   // 最大值 find函数在找不到指定值得情况下会返回string::npos
         return "text/plain";
     }
-    std::string suffix = path_.substr(idx);
+    std::string suffix = path.substr(idx);
     if(SUFFIX_TYPE.count(suffix) == 1) {
         return SUFFIX_TYPE.find(suffix)->second;
     }
     return "text/plain";
 }
 
-void HttpResponse::ErrorContent(LinearBuffer& buff, std::string message) 
+void HttpResponse::ErrorContent(ChainBuffer& buff, std::string message) 
 {
     std::string body;
     std::string status;
@@ -168,6 +226,7 @@ void HttpResponse::ErrorContent(LinearBuffer& buff, std::string message)
     body += "<p>" + message + "</p>";
     body += "<hr><em>TinyWebServer</em></body></html>";
 
+    buff.append("Content-type: text/html\r\n");
     buff.append("Content-length: " + std::to_string(body.size()) + "\r\n\r\n");
     buff.append(body);
 }
@@ -2,12 +2,12 @@
 #define HTTP_RESPONSE_H
 
 #include <unordered_map>
-#include <fcntl.h>       // open
-#include <unistd.h>      // close
-#include <sys/stat.h>    // stat
-#include <sys/mman.h>    // mmap, munmap
+#include <memory>
 
 #include "buffer/buffer.h"
+#include "buffer/chainBuffer.h"
+#include "http/fileCache.h"
+#include "http/responseCache.h"
 #include "log/log.h"
 
 class HttpResponse {
@@ -15,24 +15,29 @@ public:
     HttpResponse();
     ~HttpResponse();
 
-    void Init(const std::string& srcDir, std::string& path, bool isKeepAlive = false, int code = -1);
-    void MakeResponse(LinearBuffer& buff);
-    void UnmapFile();
-    char* File();
+    void Init(const std::string& srcDir, std::string& path, bool isKeepAlive = false, int code = -1, bool sendFile = false);
+    // 整个响应追加到链上：状态行和头部是静态字符串或复制的小段数据，
+    // 文件内容、缓存的响应由链持有引用，sendfile模式下文件作为文件切片追加
+    void MakeResponse(ChainBuffer& buff);
+    void ReleaseFile();
     size_t FileLen() const;
-    void ErrorContent(LinearBuffer& buff, std::string message);
+    void ErrorContent(ChainBuffer& buff, std::string message);
     int Code() const { return code_; }
 
+    static std::string GetFileType(const std::string& path);
+
 private:
-    void AddStateLine_(LinearBuffer &buff);
-    void AddHeader_(LinearBuffer &buff);
-    void AddContent_(LinearBuffer &buff);
+    void AddStateLine_(ChainBuffer &buff);
+    void AddDate_(ChainBuffer &buff);
+    void AddHeader_(ChainBuffer &buff);
+    void AddContent_(ChainBuffer &buff);
 
     void ErrorHtml_();
-    std::string GetFileType_();
+    bool CachedResponse_();
 
     int code_;
     bool isKeepAlive_;
+    bool sendFile_;
     int Errno;
 
     // 请求的资源路径
@@ -40,13 +45,16 @@ private:
     // 资源根目录
     std::string srcDir_;
     
-    // mmap映射的文件指针，响应静态资源
-    char* mmFile_; 
-    // 文件状态信息
-    struct stat mmFileStat_;
+    // 打开文件缓存中的文件，持有期间fd和映射都不会被释放
+    // sendfile模式下只使用fd，不做映射，直接从文件发送到套接字
+    std::shared_ptr<const CachedFile> file_;
+    // 小文件的完整响应，不包含Date头，Date头每秒都会变化，发送时插在状态行之后
+    ResponseCache::Block block_;
+    size_t blockStateLen_;
 
     static const std::unordered_map<std::string, std::string> SUFFIX_TYPE;  // 后缀类型集
     static const std::unordered_map<int, std::string> CODE_STATUS;          // 编码状态集
+    static const std::unordered_map<int, std::string> STATE_LINE;           // 完整的状态行，直接引用不复制
     static const std::unordered_map<int, std::string> CODE_PATH;            // 编码路径集
 };
 
@@ -0,0 +1,82 @@
+#include "http/responseCache.h"
+
+ResponseCache* ResponseCache::getInstance()
+{
+    static ResponseCache cache;
+    return &cache;
+}
+
+ResponseCache::ResponseCache(size_t maxFileSize, size_t maxMemory):
+    memory_(0), maxFileSize_(maxFileSize), maxMemory_(maxMemory)
+{}
+
+void ResponseCache::setLimits(size_t maxFileSize, size_t maxMemory)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    maxFileSize_ = maxFileSize;
+    maxMemory_ = maxMemory;
+    if (maxFileSize == 0) {
+        lru_.clear();
+        index_.clear();
+        memory_ = 0;
+        return;
+    }
+    while (!lru_.empty() && memory_ > maxMemory_) {
+        Erase_(std::prev(lru_.end()));
+    }
+}
+
+ResponseCache::Block ResponseCache::get(const std::string& key, const std::shared_ptr<const CachedFile>& file)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        return nullptr;
+    }
+    if (it->second->file != file) {
+        Erase_(it->second);
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->block;
+}
+
+void ResponseCache::put(const std::string& key, const std::shared_ptr<const CachedFile>& file, Block block)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    // 检查之后缓存可能已经被关闭
+    if (maxFileSize_ == 0 || block->size() > maxMemory_) {
+        return;
+    }
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        Erase_(it->second);
+    }
+    memory_ += block->size();
+    lru_.push_front({key, file, std::move(block)});
+    index_[key] = lru_.begin();
+    while (memory_ > maxMemory_) {
+        Erase_(std::prev(lru_.end()));
+    }
+}
+
+void ResponseCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    lru_.clear();
+    index_.clear();
+    memory_ = 0;
+}
+
+size_t ResponseCache::memory()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    return memory_;
+}
+
+void ResponseCache::Erase_(std::list<Entry>::iterator it)
+{
+    memory_ -= it->block->size();
+    index_.erase(it->key);
+    lru_.erase(it);
+}
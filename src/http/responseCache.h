@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "http/fileCache.h"
+
+#define RESPONSE_CACHE_FILE_SIZE (64 * 1024)
+#define RESPONSE_CACHE_MEMORY (64 * 1024 * 1024)
+
+/*
+小文件的完整响应缓存，缓存项是状态行、头部和文件内容拼在一起的一整块内存
+命中时连接直接把iovec指向这块内存，不需要再拼响应头、映射或者发送文件
+缓存项记录生成时使用的打开文件缓存项，文件缓存发现文件变化后返回新的对象，旧的响应随之失效
+超过内存上限时按LRU淘汰，响应块是引用计数的，被淘汰时正在发送的连接不受影响
+*/
+class ResponseCache {
+public:
+    typedef std::shared_ptr<const std::string> Block;
+
+    static ResponseCache* getInstance();
+
+    // maxFileSize为0时关闭缓存，同时丢弃已有的缓存项
+    void setLimits(size_t maxFileSize, size_t maxMemory);
+    // 不加锁，可以和setLimits并发调用，put时还会在锁内再检查一次
+    bool cacheable(size_t fileSize) const {
+        size_t maxFileSize = maxFileSize_.load(std::memory_order_relaxed);
+        return maxFileSize > 0 && fileSize <= maxFileSize && fileSize < maxMemory_.load(std::memory_order_relaxed);
+    }
+
+    // 缓存项不存在或者文件已经变化时返回nullptr
+    Block get(const std::string& key, const std::shared_ptr<const CachedFile>& file);
+    void put(const std::string& key, const std::shared_ptr<const CachedFile>& file, Block block);
+    void clear();
+
+    size_t memory();
+
+private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const CachedFile> file;
+        Block block;
+    };
+
+    ResponseCache(size_t maxFileSize = RESPONSE_CACHE_FILE_SIZE, size_t maxMemory = RESPONSE_CACHE_MEMORY);
+    ~ResponseCache() = default;
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    void Erase_(std::list<Entry>::iterator it);
+
+    std::mutex mtx_;
+    // 链表头部是最近使用的缓存项
+    std::list<Entry> lru_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    size_t memory_;
+    // 只在持有锁时修改
+    std::atomic<size_t> maxFileSize_;
+    std::atomic<size_t> maxMemory_;
+};
@@ -2,12 +2,19 @@
 #include <deque>
 #include <condition_variable>
 #include <mutex>
+#include <memory>
+#include <thread>
 #include <sys/time.h>
+#include "util/mpmcQueue.h"
 
+/*
+日志使用的阻塞队列
+lockFree为true时使用无锁环形队列，满和空时在futex上睡眠，否则使用互斥锁加deque
+*/
 template <typename T>
 class BlockQueue {
 public:
-    explicit BlockQueue(size_t maxsize = 1000);
+    explicit BlockQueue(size_t maxsize = 1000, bool lockFree = false);
     ~BlockQueue();
     
     void push_back(const T& message);
@@ -26,11 +33,16 @@ private:
     size_t m_capacity;
     std::condition_variable m_condProducer;
     std::condition_variable m_condConsumer;
+    std::unique_ptr<MpmcQueue<T>> m_ring;
 };
 
 template <typename T>
-inline BlockQueue<T>::BlockQueue(size_t maxsize): m_capacity(maxsize), m_isClose(false)
-{}
+inline BlockQueue<T>::BlockQueue(size_t maxsize, bool lockFree): m_capacity(maxsize), m_isClose(false)
+{
+    if (lockFree) {
+        m_ring.reset(new MpmcQueue<T>(maxsize));
+    }
+}
 
 template <typename T>
 inline BlockQueue<T>::~BlockQueue()
@@ -41,6 +53,10 @@ inline BlockQueue<T>::~BlockQueue()
 template <typename T>
 inline void BlockQueue<T>::push_back(const T &message)
 {
+    if (m_ring) {
+        m_ring->push(message);
+        return;
+    }
     std::unique_lock<std::mutex> lock(m_mtx);
     m_condProducer.wait(lock, [this]() { return m_deq.size() < m_capacity || m_isClose; });
 
@@ -53,6 +69,9 @@ inline void BlockQueue<T>::push_back(const T &message)
 template <typename T>
 inline bool BlockQueue<T>::pop(T &item)
 {
+    if (m_ring) {
+        return m_ring->pop(item);
+    }
     std::unique_lock<std::mutex> lock(m_mtx);
     m_condConsumer.wait(lock, [this](){ return m_deq.size() || m_isClose; });
     
@@ -68,6 +87,11 @@ inline bool BlockQueue<T>::pop(T &item)
 template <typename T>
 inline void BlockQueue<T>::clear()
 {
+    if (m_ring) {
+        T item;
+        while (m_ring->tryPop(item)) {}
+        return;
+    }
     std::unique_lock<std::mutex> lock(m_mtx);
     m_deq.clear();
 }
@@ -75,6 +99,9 @@ inline void BlockQueue<T>::clear()
 template <typename T>
 inline bool BlockQueue<T>::empty()
 {
+    if (m_ring) {
+        return m_ring->empty();
+    }
     std::unique_lock<std::mutex> lock(m_mtx);
     return m_deq.empty();
 }
@@ -82,6 +109,13 @@ inline bool BlockQueue<T>::empty()
 template <typename T>
 inline void BlockQueue<T>::flush()
 {
+    // 消费者一直在取，等待队列取空即可
+    if (m_ring) {
+        while (!m_ring->empty()) {
+            std::this_thread::yield();
+        }
+        return;
+    }
     std::unique_lock<std::mutex> lock(m_mtx);
     while (!m_deq.empty()) {
         m_condConsumer.notify_one();
@@ -91,6 +125,10 @@ inline void BlockQueue<T>::flush()
 template <typename T>
 inline void BlockQueue<T>::close()
 {
+    if (m_ring) {
+        m_ring->close();
+        return;
+    }
     {
         std::unique_lock<std::mutex> lock(m_mtx);
         m_isClose = true;
@@ -1,5 +1,9 @@
 #include "log/log.h"
+#include "timer/cachedClock.h"
+#include "util/affinity.h"
 
+bool Log::s_lockFreeQueue = false;
+std::atomic<bool> Log::s_created(false);
 
 Log *Log::getInstance()
 {
@@ -7,14 +11,24 @@ Log *Log::getInstance()
     return &log;
 }
 
+bool Log::init(bool lockFreeQueue)
+{
+    if (s_created.load()) {
+        return false;
+    }
+    s_lockFreeQueue = lockFreeQueue;
+    return true;
+}
+
 Log::Log(int maxLines, std::string saveDir, std::string suffix, bool isClose): 
                                             MAX_LINES(maxLines),
                                             m_saveDir(saveDir),
                                             m_suffix(suffix),
                                             m_isClose(isClose)
 {
+    s_created = true;
     m_lineCount = 0;
-    m_deque = std::make_unique<BlockQueue<std::string>>();
+    m_deque = std::make_unique<BlockQueue<std::string>>(LOG_QUEUE_SIZE, s_lockFreeQueue);
     m_writeThread = std::make_unique<std::thread>(&Log::FlushLogThread);
     changeFile();
 }
@@ -51,6 +65,11 @@ void Log::asyncWrite()
     }
 }
 
+bool Log::setCpu(int cpu)
+{
+    return affinity::pinThread(m_writeThread->native_handle(), cpu);
+}
+
 bool Log::isClosed()
 {
     std::unique_lock<std::mutex> lock(m_mtx);
@@ -69,19 +88,22 @@ void Log::write(int level, const char *format, ...)
 
     va_list args;
     va_start(args, format);
+    std::string line;
     {
         std::unique_lock<std::mutex> lock(m_mtx);
         ++m_lineCount;
         
-        m_buff.append(temp.transToString());
+        m_buff.append(CachedClock::logTime(), 20);
         appendLogLevelTitle(level);
         vsnprintf(message, sizeof(message), format, args);
         m_buff.append(message);
         m_buff.append("\n");
 
-        m_deque->push_back(m_buff.getReadAbleBytes());
+        line = m_buff.getReadAbleBytes();
     }
     va_end(args);
+    // 队列满时push_back会阻塞，不能持有m_mtx，否则写线程拿不到锁，队列永远不会变空
+    m_deque->push_back(line);
 }
 
 void Log::appendLogLevelTitle(int level)
@@ -129,10 +151,10 @@ void Log::changeFile()
     m_lineCount = 0;
 }
 
+// 使用事件循环缓存的时间，不需要每一行日志都调用time和localtime
 Day Log::getToday()
 {
-    time_t timer = time(nullptr);
-    tm t = *localtime(&timer);
+    const tm& t = CachedClock::localTime();
 
     Day res;
     res.year = t.tm_year;
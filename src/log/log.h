@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <mutex>
 #include <memory>
+#include <atomic>
 #include <sstream>
 #include <iomanip>
 #include <sys/time.h>
@@ -12,6 +13,9 @@
 #include "buffer/linearBuffer.h"
 #include "blockqueue.h"
 
+// 日志队列的长度
+#define LOG_QUEUE_SIZE 1024
+
 /*
 日志应该是线程安全的, 因此使用日志的部分不需要额外确定线程安全
 只支持写所有的日志记录，如果想要筛选，请按照格式转换成csv文件在表格中进行筛选
@@ -49,11 +53,19 @@ struct Day {
 class Log {
 public:
     static Log* getInstance();
+    // 选择日志队列，默认使用互斥锁队列，lockFreeQueue为true时使用无锁环形队列
+    // 日志在第一次写入时创建，之后再调用不生效，返回false
+    static bool init(bool lockFreeQueue);
     static void FlushLogThread(); 
     bool isClosed();
     void write(int level, const char* format, ...);
+    // 把写日志的线程绑定到cpu上
+    bool setCpu(int cpu);
 
 private:
+    static bool s_lockFreeQueue;
+    static std::atomic<bool> s_created;
+
     LinearBuffer m_buff;
     FILE* m_fp;
     std::unique_ptr<BlockQueue<std::string>> m_deque;
@@ -1,71 +1,292 @@
 #pragma once
 
-#include <mutex>
-#include <condition_variable>
-#include <queue>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 
 /*
 此对象池用于连接对象创建时的复用工作
-现在使用单例模式的饿汉式来保证线程安全
-后期可以考虑动态的伸缩这个对象池
+对象在需要时才创建，最多创建maxSize个，达到上限后acquireObject立即返回nullptr，由调用方拒绝连接，不会阻塞事件循环
+每个线程有自己的缓存，获取和归还通常不需要任何同步；缓存空了从全局空闲链表取一批，缓存满了归还一批
+全局空闲链表是无锁栈，用下标加版本号代替指针，避免ABA问题
 */
 
 const int defaultSize = 50;
+const size_t defaultMaxSize = 65536;
+// 线程缓存和全局空闲链表每次交换的对象数，线程缓存最多保存两倍
+#define OBJECT_MAGAZINE_SIZE 16
+
+// 与对象类型无关的部分：线程缓存的查找和线程退出时的归还
+class ObjectPoolBase {
+public:
+    ObjectPoolBase(const ObjectPoolBase&) = delete;
+    ObjectPoolBase& operator=(const ObjectPoolBase&) = delete;
+
+protected:
+    // 只由所属线程访问，保存的是对象的下标
+    struct Cache {
+        uint32_t objs[OBJECT_MAGAZINE_SIZE * 2];
+        size_t count = 0;
+    };
+
+    ObjectPoolBase();
+    virtual ~ObjectPoolBase() = default;
+
+    // 派生类析构时最先调用，之后退出的线程不会再把缓存还给这个对象池
+    void unregisterPool();
+    Cache* localCache();
+    // 把缓存中的对象全部还给全局空闲链表
+    virtual void flushCache(Cache* cache) = 0;
+
+private:
+    // 线程退出时把缓存还给仍然存活的对象池，否则这些对象在对象池析构之前都无法再使用
+    struct ThreadCaches {
+        uint64_t lastId = 0;
+        Cache* last = nullptr;
+        std::vector<std::pair<uint64_t, Cache*>> caches;
+        ~ThreadCaches();
+    };
+    static ThreadCaches& threadCaches();
+
+    uint64_t m_id;
+    // 所有线程的缓存由对象池释放，以下由s_mtx保护
+    std::vector<std::unique_ptr<Cache>> m_caches;
+
+    static inline std::mutex s_mtx;
+    static inline std::unordered_map<uint64_t, ObjectPoolBase*> s_pools;
+    static inline std::atomic<uint64_t> s_nextId{1};
+};
 
 template <typename Obj>
-class ObjectPool{
+class ObjectPool : public ObjectPoolBase {
 public:
+    // 预先创建poolSize个对象，之后按需创建，最多maxSize个，args用于构造每一个对象
     template<typename... Args>
-    ObjectPool(size_t poolSize = defaultSize, Args&&... args);
+    ObjectPool(size_t poolSize = defaultSize, size_t maxSize = defaultMaxSize, Args... args);
+    // 销毁所有创建过的对象，包括还没有归还的
     ~ObjectPool();
 
-    ObjectPool(const ObjectPool&) = delete;
-    ObjectPool& operator=(ObjectPool&) = delete;
-
+    // 已经创建了maxSize个对象并且都在使用时返回nullptr
     Obj* acquireObject();
     void releaseObject(Obj* obj);
 
+    size_t created() const { return m_created.load(std::memory_order_relaxed); }
+    size_t maxSize() const { return m_maxSize; }
+
 private:
-    std::queue<Obj*> m_pool;
-    std::mutex m_mtx;
-    std::condition_variable m_cond;
+    struct Slot {
+        // 空闲链表中下一个对象的下标加1，0表示链表结束
+        std::atomic<uint32_t> next;
+        uint32_t index;
+        alignas(Obj) unsigned char data[sizeof(Obj)];
+    };
+
+    Slot* slot(uint32_t index) const { return m_slots[index].load(std::memory_order_acquire); }
+    Obj* object(uint32_t index) const { return reinterpret_cast<Obj*>(slot(index)->data); }
+    uint32_t indexOf(Obj* obj) const {
+        return reinterpret_cast<Slot*>(reinterpret_cast<unsigned char*>(obj) - offsetof(Slot, data))->index;
+    }
+
+    Slot* grow();
+    bool refill(Cache* cache);
+    // 把objs中的count个对象连成一条链，一次放入全局空闲链表
+    void pushFree(const uint32_t* objs, size_t count);
+    bool popFree(uint32_t& index);
+    void flushCache(Cache* cache) override;
+
+    std::function<void(void*)> m_construct;
+    size_t m_maxSize;
+    std::unique_ptr<std::atomic<Slot*>[]> m_slots;
+    std::atomic<size_t> m_created;
+    // 低32位是栈顶下标加1，高32位是版本号，每次修改都加1
+    std::atomic<uint64_t> m_head;
 };
 
 
+inline ObjectPoolBase::ObjectPoolBase() : m_id(s_nextId++)
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+    s_pools[m_id] = this;
+}
+
+inline void ObjectPoolBase::unregisterPool()
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+    s_pools.erase(m_id);
+}
+
+inline ObjectPoolBase::ThreadCaches& ObjectPoolBase::threadCaches()
+{
+    static thread_local ThreadCaches caches;
+    return caches;
+}
+
+inline ObjectPoolBase::ThreadCaches::~ThreadCaches()
+{
+    std::lock_guard<std::mutex> lock(s_mtx);
+    for (auto& item : caches) {
+        auto it = s_pools.find(item.first);
+        if (it != s_pools.end()) {
+            it->second->flushCache(item.second);
+        }
+    }
+}
+
+inline ObjectPoolBase::Cache* ObjectPoolBase::localCache()
+{
+    ThreadCaches& tc = threadCaches();
+    if (tc.lastId == m_id) return tc.last;
+    Cache* cache = nullptr;
+    for (auto& item : tc.caches) {
+        if (item.first == m_id) {
+            cache = item.second;
+            break;
+        }
+    }
+    if (cache == nullptr) {
+        std::lock_guard<std::mutex> lock(s_mtx);
+        // 顺便去掉已经析构的对象池的缓存
+        for (size_t i = 0; i < tc.caches.size(); ) {
+            if (s_pools.count(tc.caches[i].first) == 0) {
+                tc.caches[i] = tc.caches.back();
+                tc.caches.pop_back();
+            } else {
+                ++ i;
+            }
+        }
+        cache = new Cache;
+        m_caches.emplace_back(cache);
+        tc.caches.emplace_back(m_id, cache);
+    }
+    tc.lastId = m_id;
+    tc.last = cache;
+    return cache;
+}
+
+
 template <typename Obj>
 template<typename... Args>
-inline ObjectPool<Obj>::ObjectPool(size_t poolSize, Args&&... args)
+inline ObjectPool<Obj>::ObjectPool(size_t poolSize, size_t maxSize, Args... args) :
+    m_construct([args...](void* p) { new (p) Obj(args...); }),
+    m_maxSize(std::min<size_t>(std::max(maxSize, poolSize), UINT32_MAX - 1)),
+    m_slots(new std::atomic<Slot*>[m_maxSize]), m_created(0), m_head(0)
 {
+    for (size_t i = 0; i < m_maxSize; ++ i) {
+        m_slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+    std::vector<uint32_t> objs;
     for (size_t i = 0; i < poolSize; ++ i) {
-        m_pool.push(new Obj(std::forward<Args>(args)...));
+        objs.push_back(grow()->index);
+    }
+    pushFree(objs.data(), objs.size());
+}
+
+template <typename Obj>
+ObjectPool<Obj>::~ObjectPool()
+{
+    unregisterPool();
+    size_t created = m_created.load();
+    for (size_t i = 0; i < created; ++ i) {
+        Slot* s = slot(i);
+        if (s == nullptr) continue;
+        reinterpret_cast<Obj*>(s->data)->~Obj();
+        delete s;
     }
 }
 
 template <typename Obj>
 Obj* ObjectPool<Obj>::acquireObject()
 {
-    std::unique_lock<std::mutex> lock(m_mtx);
-    m_cond.wait(lock, [this]() {return !m_pool.empty();});
-    
-    auto obj = m_pool.front();
-    m_pool.pop();
-    return obj;
+    Cache* cache = localCache();
+    if (cache->count == 0 && !refill(cache)) {
+        Slot* s = grow();
+        return s ? reinterpret_cast<Obj*>(s->data) : nullptr;
+    }
+    return object(cache->objs[-- cache->count]);
 }
 
 template <typename Obj>
 void ObjectPool<Obj>::releaseObject(Obj* obj)
 {
-    std::unique_lock<std::mutex> lock(m_mtx);
-    m_pool.push(obj);
-    m_cond.notify_one();
+    Cache* cache = localCache();
+    // 缓存满了，把先放入的一半还给全局空闲链表，刚归还的对象留在本线程
+    if (cache->count == OBJECT_MAGAZINE_SIZE * 2) {
+        pushFree(cache->objs, OBJECT_MAGAZINE_SIZE);
+        memmove(cache->objs, cache->objs + OBJECT_MAGAZINE_SIZE, OBJECT_MAGAZINE_SIZE * sizeof(uint32_t));
+        cache->count = OBJECT_MAGAZINE_SIZE;
+    }
+    cache->objs[cache->count ++] = indexOf(obj);
 }
 
 template <typename Obj>
-ObjectPool<Obj>::~ObjectPool()
+typename ObjectPool<Obj>::Slot* ObjectPool<Obj>::grow()
 {
-    while (!m_pool.empty()) {
-        delete m_pool.front();
-        m_pool.pop();
+    size_t index = m_created.load(std::memory_order_relaxed);
+    do {
+        if (index >= m_maxSize) return nullptr;
+    } while (!m_created.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+
+    Slot* s = new Slot;
+    s->next.store(0, std::memory_order_relaxed);
+    s->index = static_cast<uint32_t>(index);
+    m_construct(s->data);
+    m_slots[index].store(s, std::memory_order_release);
+    return s;
+}
+
+template <typename Obj>
+bool ObjectPool<Obj>::refill(Cache* cache)
+{
+    uint32_t index;
+    while (cache->count < OBJECT_MAGAZINE_SIZE && popFree(index)) {
+        cache->objs[cache->count ++] = index;
+    }
+    return cache->count > 0;
+}
+
+template <typename Obj>
+void ObjectPool<Obj>::pushFree(const uint32_t* objs, size_t count)
+{
+    if (count == 0) return;
+    for (size_t i = 0; i + 1 < count; ++ i) {
+        slot(objs[i])->next.store(objs[i + 1] + 1, std::memory_order_relaxed);
+    }
+    Slot* last = slot(objs[count - 1]);
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    uint64_t newHead;
+    do {
+        last->next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        newHead = (((head >> 32) + 1) << 32) | (objs[0] + 1);
+    } while (!m_head.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+}
+
+template <typename Obj>
+bool ObjectPool<Obj>::popFree(uint32_t& index)
+{
+    uint64_t head = m_head.load(std::memory_order_acquire);
+    while (static_cast<uint32_t>(head) != 0) {
+        uint32_t top = static_cast<uint32_t>(head) - 1;
+        // 栈顶可能已经被其它线程取走，版本号保证这时CAS失败
+        uint32_t next = slot(top)->next.load(std::memory_order_relaxed);
+        uint64_t newHead = (((head >> 32) + 1) << 32) | next;
+        if (m_head.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire)) {
+            index = top;
+            return true;
+        }
     }
-}
\ No newline at end of file
+    return false;
+}
+
+template <typename Obj>
+void ObjectPool<Obj>::flushCache(Cache* cache)
+{
+    pushFree(cache->objs, cache->count);
+    cache->count = 0;
+}
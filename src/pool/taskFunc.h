@@ -0,0 +1,116 @@
+#pragma once
+
+#include <new>
+#include <utility>
+#include <stddef.h>
+#include <type_traits>
+
+// 可调用对象不超过这个大小时直接存放在TaskFunc内部，不分配内存
+#define TASK_INLINE_SIZE 48
+
+/*
+只能移动的void()可调用对象，用来代替线程池中的std::function
+小对象（例如捕获了几个指针的lambda）存放在内部的缓冲区中，没有堆分配也没有共享状态
+可以保存std::packaged_task这类不能复制的对象
+*/
+class TaskFunc {
+public:
+    TaskFunc() : m_ops(nullptr) {}
+
+    template <typename F, typename Fn = typename std::decay<F>::type,
+              typename = typename std::enable_if<!std::is_same<Fn, TaskFunc>::value>::type>
+    TaskFunc(F&& f) : m_ops(&OpsFor<Fn>::ops) {
+        OpsFor<Fn>::create(m_storage, std::forward<F>(f));
+    }
+
+    TaskFunc(TaskFunc&& other) noexcept : m_ops(other.m_ops) {
+        if (m_ops) {
+            m_ops->move(m_storage, other.m_storage);
+            other.m_ops = nullptr;
+        }
+    }
+
+    TaskFunc& operator=(TaskFunc&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_ops = other.m_ops;
+            if (m_ops) {
+                m_ops->move(m_storage, other.m_storage);
+                other.m_ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    TaskFunc(const TaskFunc&) = delete;
+    TaskFunc& operator=(const TaskFunc&) = delete;
+
+    ~TaskFunc() { reset(); }
+
+    void operator()() { m_ops->call(m_storage); }
+    explicit operator bool() const { return m_ops != nullptr; }
+
+    void reset() {
+        if (m_ops) {
+            m_ops->destroy(m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*call)(void* storage);
+        // 移动到dst并销毁src中的对象
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void* storage);
+    };
+
+    // 放得下并且移动不会抛异常的对象内联存放，否则在堆上分配，内部只保存指针
+    template <typename Fn>
+    struct OpsFor {
+        static constexpr bool INLINE = sizeof(Fn) <= TASK_INLINE_SIZE &&
+                                   alignof(Fn) <= alignof(max_align_t) &&
+                                   std::is_nothrow_move_constructible<Fn>::value;
+
+        template <typename F>
+        static void create(void* storage, F&& f) {
+            if constexpr (INLINE) {
+                new (storage) Fn(std::forward<F>(f));
+            }
+            else {
+                *static_cast<Fn**>(storage) = new Fn(std::forward<F>(f));
+            }
+        }
+        static Fn* get(void* storage) {
+            if constexpr (INLINE) {
+                return static_cast<Fn*>(storage);
+            }
+            else {
+                return *static_cast<Fn**>(storage);
+            }
+        }
+        static void call(void* storage) { (*get(storage))(); }
+        static void move(void* dst, void* src) {
+            if constexpr (INLINE) {
+                new (dst) Fn(std::move(*get(src)));
+                get(src)->~Fn();
+            }
+            else {
+                *static_cast<Fn**>(dst) = get(src);
+            }
+        }
+        static void destroy(void* storage) {
+            if constexpr (INLINE) {
+                get(storage)->~Fn();
+            }
+            else {
+                delete get(storage);
+            }
+        }
+
+        static constexpr Ops ops = {&call, &move, &destroy};
+    };
+
+    alignas(max_align_t) unsigned char m_storage[TASK_INLINE_SIZE];
+    const Ops* m_ops;
+};
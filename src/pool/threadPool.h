@@ -1,5 +1,7 @@
 #pragma once
 #include <list>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <functional>
@@ -11,20 +13,66 @@
 #include <initializer_list>
 #include <unordered_map>
 #include "log/log.h"
+#include "pool/workStealingDeque.h"
+#include "pool/taskFunc.h"
+#include "util/mpmcQueue.h"
+#include "util/affinity.h"
 
 #define MIN_THREADS 4
 #define MAX_THREADS 40
 #define DEFAULT_THREADS 4
-#define DEFAULT_INTERVAL 5000
+// 自适应调整线程数的控制周期，毫秒
+#define DEFAULT_INTERVAL 100
+// 任务平均排队时间超过这个值时扩容，微秒
+#define POOL_TARGET_WAIT_US 1000
+// 排队时间很短并且利用率低于这个值时才考虑缩容
+#define POOL_LOW_UTILIZATION 0.5
+// 连续这么多个周期满足缩容条件才缩容，避免来回抖动
+#define POOL_SHRINK_TICKS 20
+// 工作线程从全局注入队列中一次最多取走的任务数
+#define INJECT_BATCH 32
+// 工作窃取和无锁队列模式下，工作线程找不到任务时睡眠前的重试次数
+#define STEAL_SPINS 16
+// 无锁队列模式的环形队列长度
+#define TASK_RING_SIZE 4096
 
+// 调度模式
+enum SCHED_MODE {
+    SHARED_QUEUE,   // 所有线程共用一个加锁的优先队列
+    WORK_STEALING,  // 每个线程一个工作窃取双端队列，外部提交的任务放入全局注入队列
+    LOCK_FREE_QUEUE,    // 所有线程共用一个无锁环形队列，空闲线程在futex上睡眠
+};
+
+// 自适应调整的参数，见上面的默认值
+struct PoolTuning {
+    int64_t targetWaitUs = POOL_TARGET_WAIT_US;
+    double lowUtilization = POOL_LOW_UTILIZATION;
+    int shrinkTicks = POOL_SHRINK_TICKS;
+};
+
+// 线程池的运行状态，waitUs和utilization是最近一个控制周期的值
+struct PoolStats {
+    size_t threads = 0;
+    int busy = 0;
+    size_t queued = 0;
+    uint64_t completed = 0;
+    double waitUs = 0;
+    double utilization = 0;
+    uint64_t grows = 0;
+    uint64_t shrinks = 0;
+};
+
+// 任务只能移动，入队出队都不会复制可调用对象
 class Task {
 public:
-    std::function<void()> func;
+    TaskFunc func;
     unsigned int priority;
+    // 入队的时间，微秒，用来统计排队时间
+    int64_t enqueueTime = 0;
 
 public:
     Task() = default;
-    Task(std::function<void()> f, unsigned int p) : func(std::move(f)), priority(p) {}
+    Task(TaskFunc f, unsigned int p, int64_t t = 0) : func(std::move(f)), priority(p), enqueueTime(t) {}
 
     bool operator<(const Task& other) const {
         return priority < other.priority;
@@ -61,11 +109,21 @@ public:
         m_queue.push(std::forward<T>(t));
     }
 
+    // 一次加锁放入n个元素，make(i)生成第i个元素
+    template <typename Make>
+    void enqueueBatch(size_t n, Make make) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < n; ++i) {
+            m_queue.push(make(i));
+        }
+    }
+
     bool dequeue(T& t) {
         std::unique_lock<std::mutex> lock(m_mutex);
         if (m_queue.empty())
             return false;
-        t = std::move(m_queue.top());
+        // top只返回const引用，元素马上就会被弹出，可以直接移走
+        t = std::move(const_cast<T&>(m_queue.top()));
         m_queue.pop();
         return true;
     }
@@ -77,46 +135,51 @@ private:
     class ThreadWorker {
     private:
         ThreadPool* m_pool;
+        // 工作窃取模式下使用的双端队列
+        int m_index;
 
     public:
-        ThreadWorker(ThreadPool* pool) : m_pool(pool) {}
+        ThreadWorker(ThreadPool* pool, int index = -1) : m_pool(pool), m_index(index) {}
 
         void operator()() {
+            m_pool->pinWorker(m_index);
+            if (m_pool->m_mode == WORK_STEALING) {
+                m_pool->stealingLoop(m_index);
+                return;
+            }
+            if (m_pool->m_mode == LOCK_FREE_QUEUE) {
+                m_pool->ringLoop();
+                return;
+            }
             Task t;
             bool dequeued;
             while (true) {
                 {
                     std::unique_lock<std::mutex> lock(m_pool->m_conditional_mutex);
-                    m_pool->m_conditional_lock.wait(lock, [this] { return !m_pool->m_queue.empty() || m_pool->m_shutdown; });
-                    if (m_pool->m_shutdown && m_pool->m_queue.empty()) break;
+                    m_pool->m_conditional_lock.wait(lock, [this] {
+                        return !m_pool->m_queue.empty() || m_pool->m_shutdown || m_pool->m_shrink > 0;
+                    });
                     dequeued = m_pool->m_queue.dequeue(t);
-                }
-                if (dequeued)
-                {
-                    ++m_pool->work_nums;
-                    --m_pool->sleep_nums;
-                    t.func();
-                    --m_pool->work_nums;
-                    ++m_pool->sleep_nums;
-                }
-                // 在没有任务并且被通知了，说明要缩减线程
-                else
-                {
-                    std::unique_lock<std::mutex> lock(m_pool->m_mutex);
-                    std::thread::id this_id = std::this_thread::get_id();
-                    if (m_pool->mp.count(this_id))
-                    {
-                        m_pool->lst_threads.erase(m_pool->mp[this_id]);
-                        m_pool->mp.erase(this_id);
-                        --m_pool->sleep_nums;
+                    if (!dequeued) {
+                        if (m_pool->m_shutdown) break;
+                        // 被通知但没有任务不代表需要缩减，只有控制器要求时才退出
+                        int shrink = m_pool->m_shrink;
+                        if (shrink > 0 && m_pool->m_shrink.compare_exchange_strong(shrink, shrink - 1)) {
+                            lock.unlock();
+                            m_pool->retireWorker(m_index);
+                            return;
+                        }
+                        continue;
                     }
-                    return;
                 }
+                m_pool->runTask(t);
             }
         }
     };
 
-    bool m_shutdown;
+    std::atomic<bool> m_shutdown;
+    SCHED_MODE m_mode;
+    // 共享队列模式下的任务队列，工作窃取和无锁队列模式下只存放优先级不为0的任务
     SafeQueue<Task> m_queue;
     std::mutex m_conditional_mutex;
     std::mutex m_mutex;
@@ -128,32 +191,140 @@ private:
     std::list<std::thread> lst_threads;
     std::atomic<int> work_nums;
     std::atomic<int> sleep_nums;
-    // 引入定时器机制和定时器线程
+    // 控制器线程，按周期根据排队时间和利用率调整线程数，关闭时立即唤醒
     std::chrono::milliseconds timer_interval;
     std::thread timer_thread;
+    std::mutex m_timerMutex;
+    std::condition_variable m_timerCond;
+    PoolTuning m_tuning;
+    // 工作线程累加，控制器每个周期取走
+    std::atomic<int64_t> m_waitSum;
+    std::atomic<int64_t> m_waitCount;
+    std::atomic<int64_t> m_busyTime;
+    std::atomic<uint64_t> m_completed;
+    int64_t m_lastTick;
+    int m_idleTicks;
+    // 以下由m_mutex保护
+    PoolStats m_stats;
+
+    // 工作窃取模式
+    // 按最大线程数分配，线程退出后下标由新线程复用
+    std::vector<std::unique_ptr<WorkStealingDeque<Task*>>> m_deques;
+    std::vector<int> m_freeSlots;
+    std::deque<Task*> m_inject;
+    std::mutex m_injectMutex;
+    // 所有队列中还没有被取走的任务数，为0时工作线程才睡眠
+    std::atomic<size_t> m_pending;
+    std::atomic<size_t> m_priorityTasks;
+
+    std::atomic<int> m_sleepers;
+    // 需要退出的空闲线程数
+    std::atomic<int> m_shrink;
+
+    // 无锁队列模式
+    std::unique_ptr<MpmcQueue<Task>> m_ring;
+    EventCount m_taskEvent;
+    // 环形队列满时溢出的任务，环形队列取空之后按提交顺序取出
+    std::deque<Task> m_overflow;
+    std::mutex m_overflowMutex;
+    std::atomic<size_t> m_overflowTasks;
+
+    // 工作线程绑定的CPU，为空时不绑定
+    std::vector<int> m_cpus;
+    std::atomic<unsigned int> m_nextCpu;
+
+    // 当前线程所属的线程池和双端队列，工作线程提交的任务直接放入自己的队列
+    struct WorkerContext {
+        ThreadPool* pool;
+        int index;
+        unsigned int seed;
+    };
+    static WorkerContext& currentWorker() {
+        static thread_local WorkerContext ctx = {nullptr, -1, 0};
+        return ctx;
+    }
 
 public:
     ThreadPool(const int n_threads = DEFAULT_THREADS, const size_t min_threads = MIN_THREADS, 
                const size_t max_threads = MAX_THREADS, 
-               std::chrono::milliseconds interval = std::chrono::milliseconds(DEFAULT_INTERVAL)) : 
-               lst_threads(std::list<std::thread>(n_threads)), m_shutdown(false), min_threads(min_threads), 
+               std::chrono::milliseconds interval = std::chrono::milliseconds(DEFAULT_INTERVAL),
+               SCHED_MODE mode = SHARED_QUEUE) : 
+               lst_threads(std::list<std::thread>(n_threads)), m_shutdown(false), m_mode(mode), min_threads(min_threads), 
                max_threads(max_threads), timer_interval(interval)
     {
         work_nums = 0;
         sleep_nums = n_threads;
-        timer_thread = std::thread(&ThreadPool::timer_function, this);
-        LOG_INFO("Base thread nums: %d", n_threads);
+        m_pending = 0;
+        m_priorityTasks = 0;
+        m_overflowTasks = 0;
+        m_sleepers = 0;
+        m_shrink = 0;
+        m_nextCpu = 0;
+        m_waitSum = 0;
+        m_waitCount = 0;
+        m_busyTime = 0;
+        m_completed = 0;
+        m_lastTick = nowUs();
+        m_idleTicks = 0;
+        if (m_mode == LOCK_FREE_QUEUE) {
+            m_ring.reset(new MpmcQueue<Task>(TASK_RING_SIZE));
+        }
+        if (m_mode == WORK_STEALING) {
+            size_t slots = std::max(max_threads, (size_t)n_threads);
+            for (size_t i = 0; i < slots; ++i) {
+                m_deques.emplace_back(new WorkStealingDeque<Task*>());
+            }
+            for (size_t i = slots; i > (size_t)n_threads; --i) {
+                m_freeSlots.push_back(i - 1);
+            }
+        }
+        LOG_INFO("Base thread nums: %d, mode: %s", n_threads,
+                 m_mode == WORK_STEALING ? "work stealing" : (m_mode == LOCK_FREE_QUEUE ? "lock free queue" : "shared queue"));
     }
 
     ~ThreadPool() {
         if (!m_shutdown) shutdown();
+        // 没有调用init时队列中可能还有任务
+        for (Task* t : m_inject) {
+            delete t;
+        }
+        for (auto& deque : m_deques) {
+            while (Task* t = deque->steal()) {
+                delete t;
+            }
+        }
+    }
+
+    // 在init之前调用，工作线程启动时依次绑定到这些CPU上，之后分配的任务内存都在对应的NUMA节点上
+    void setCpus(const std::vector<int>& cpus) {
+        m_cpus = cpus;
+    }
+
+    // 在init之前调用
+    void setTuning(const PoolTuning& tuning) {
+        m_tuning = tuning;
+    }
+
+    PoolStats stats() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        PoolStats res = m_stats;
+        res.threads = lst_threads.size();
+        res.busy = work_nums;
+        res.queued = queuedTasks();
+        res.completed = m_completed;
+        return res;
     }
 
     void init() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        int index = 0;
         for (auto it = lst_threads.begin(); it != lst_threads.end(); ++it) {
-            *it = std::thread(ThreadWorker(this));
+            *it = std::thread(ThreadWorker(this, index++));
             mp[it->get_id()] = it;
         }
+        // 控制器在工作线程启动之后才开始调整
+        m_lastTick = nowUs();
+        timer_thread = std::thread(&ThreadPool::timer_function, this);
     }
 
     void shutdown() 
@@ -163,25 +334,38 @@ public:
             m_shutdown = true;
         }
 
+        // 先停止控制器，之后不会再增减线程
+        {
+            std::unique_lock<std::mutex> lock(m_timerMutex);
+        }
+        m_timerCond.notify_all();
+        if (timer_thread.joinable()) {
+            timer_thread.join();
+        }
+
         m_conditional_lock.notify_all();
-        for (auto& it : lst_threads) {
+        m_taskEvent.notifyAll();
+        // 正在退出的线程在列表中找不到自己，由这里回收
+        std::list<std::thread> threads;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            threads.swap(lst_threads);
+            mp.clear();
+        }
+        for (auto& it : threads) {
             if (it.joinable()) {
                 it.join();
             }
         }
-        if (timer_thread.joinable()) {
-            timer_thread.join();
-        }
     }
 
     template <typename F, typename... Args>
     auto submit(unsigned int priority, F&& f, Args&&... args) -> std::future<decltype(f(args...))> {
-        auto func = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
-        auto task_ptr = std::make_shared<std::packaged_task<decltype(f(args...))()>>(func);
-        Task task([task_ptr]() { (*task_ptr)(); }, priority);
-        m_queue.enqueue(std::move(task));
-        m_conditional_lock.notify_one();
-        return task_ptr->get_future();
+        // packaged_task只能移动，直接放入任务中，不再需要shared_ptr
+        std::packaged_task<decltype(f(args...))()> task(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+        auto result = task.get_future();
+        schedule(Task(std::move(task), priority));
+        return result;
     }
 
     template <typename F, typename... Args>
@@ -189,46 +373,413 @@ public:
         return submit(0, std::forward<F>(f), std::forward<Args>(args)...);
     }
 
+    // 不需要结果的任务，没有future和共享状态，捕获几个指针的lambda不会分配内存
+    template <typename F>
+    void post(unsigned int priority, F&& f) {
+        schedule(Task(std::forward<F>(f), priority));
+    }
+
+    template <typename F>
+    void post(F&& f) {
+        post(0, std::forward<F>(f));
+    }
+
+    // 一次提交多个不需要结果的任务，队列只加锁一次，只唤醒需要的线程数
+    // 任务从数组中移走，调用之后数组中的元素为空
+    void submitBatch(TaskFunc* tasks, size_t count, unsigned int priority = 0) {
+        if (count == 0) return;
+        int64_t now = nowUs();
+        if (m_mode == SHARED_QUEUE) {
+            m_queue.enqueueBatch(count, [tasks, priority, now](size_t i) { return Task(std::move(tasks[i]), priority, now); });
+            wakeShared(count);
+            return;
+        }
+        if (m_mode == LOCK_FREE_QUEUE) {
+            if (priority > 0) {
+                m_queue.enqueueBatch(count, [tasks, priority, now](size_t i) { return Task(std::move(tasks[i]), priority, now); });
+                m_priorityTasks += count;
+                m_taskEvent.notify(static_cast<int>(std::min(count, (size_t)INT_MAX)));
+                return;
+            }
+            size_t i = 0;
+            for (; i < count && m_overflowTasks == 0; ++i) {
+                Task t(std::move(tasks[i]), 0, now);
+                if (!m_ring->tryPush(std::move(t))) {
+                    // 环形队列满时放回去，和剩下的任务一起按顺序放入溢出队列
+                    tasks[i] = std::move(t.func);
+                    break;
+                }
+            }
+            if (i < count) {
+                std::lock_guard<std::mutex> lock(m_overflowMutex);
+                for (size_t k = i; k < count; ++k) {
+                    m_overflow.emplace_back(std::move(tasks[k]), 0, now);
+                }
+                m_overflowTasks += count - i;
+            }
+            m_taskEvent.notify(static_cast<int>(std::min(count, (size_t)INT_MAX)));
+            return;
+        }
+
+        if (priority > 0) {
+            m_queue.enqueueBatch(count, [tasks, priority, now](size_t i) { return Task(std::move(tasks[i]), priority, now); });
+            m_priorityTasks += count;
+        }
+        else {
+            WorkerContext& ctx = currentWorker();
+            if (ctx.pool == this) {
+                for (size_t i = 0; i < count; ++i) {
+                    m_deques[ctx.index]->push(new Task(std::move(tasks[i]), 0, now));
+                }
+            }
+            else {
+                std::lock_guard<std::mutex> lock(m_injectMutex);
+                for (size_t i = 0; i < count; ++i) {
+                    m_inject.push_back(new Task(std::move(tasks[i]), 0, now));
+                }
+            }
+        }
+        m_pending += count;
+        size_t wake = std::min(count, (size_t)std::max(0, m_sleepers.load()));
+        if (wake > 0) {
+            std::lock_guard<std::mutex> lock(m_conditional_mutex);
+            for (size_t i = 0; i < wake; ++i) {
+                m_conditional_lock.notify_one();
+            }
+        }
+    }
+
 private:
+    // 共享队列模式下最多唤醒count个空闲线程，任务比空闲线程多时全部唤醒
+    void wakeShared(size_t count) {
+        if (count >= (size_t)std::max(0, sleep_nums.load())) {
+            m_conditional_lock.notify_all();
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            m_conditional_lock.notify_one();
+        }
+    }
+
+    static int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 统计排队时间和执行时间，供控制器使用
+    void runTask(Task& t) {
+        int64_t start = nowUs();
+        m_waitSum.fetch_add(start - t.enqueueTime, std::memory_order_relaxed);
+        m_waitCount.fetch_add(1, std::memory_order_relaxed);
+        ++work_nums;
+        --sleep_nums;
+        t.func();
+        --work_nums;
+        ++sleep_nums;
+        m_busyTime.fetch_add(nowUs() - start, std::memory_order_relaxed);
+        m_completed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void schedule(Task&& task) {
+        task.enqueueTime = nowUs();
+        if (m_mode == SHARED_QUEUE) {
+            m_queue.enqueue(std::move(task));
+            m_conditional_lock.notify_one();
+            return;
+        }
+        // 有优先级的任务放入优先队列，环形队列满时放入溢出队列，提交方不会阻塞
+        // 溢出队列不为空时新任务也排在溢出队列的后面，不会越过先提交的任务
+        if (m_mode == LOCK_FREE_QUEUE) {
+            if (task.priority > 0) {
+                m_queue.enqueue(std::move(task));
+                ++m_priorityTasks;
+            }
+            else if (m_overflowTasks > 0 || !m_ring->tryPush(std::move(task))) {
+                std::lock_guard<std::mutex> lock(m_overflowMutex);
+                m_overflow.push_back(std::move(task));
+                ++m_overflowTasks;
+            }
+            m_taskEvent.notifyOne();
+            return;
+        }
+        // 有优先级的任务放入全局优先队列，工作线程总是先检查它
+        if (task.priority > 0) {
+            m_queue.enqueue(std::move(task));
+            ++m_priorityTasks;
+        }
+        else {
+            Task* t = new Task(std::move(task));
+            WorkerContext& ctx = currentWorker();
+            if (ctx.pool == this) {
+                m_deques[ctx.index]->push(t);
+            }
+            else {
+                std::lock_guard<std::mutex> lock(m_injectMutex);
+                m_inject.push_back(t);
+            }
+        }
+        // 先增加任务数再检查睡眠的线程数，和工作线程睡眠前的检查顺序相反，不会丢失唤醒
+        ++m_pending;
+        if (m_sleepers > 0) {
+            std::lock_guard<std::mutex> lock(m_conditional_mutex);
+            m_conditional_lock.notify_one();
+        }
+    }
+
+    // 依次检查优先队列、自己的双端队列、注入队列，最后随机选择其它线程窃取
+    bool findTask(int index, Task& task) {
+        if (m_priorityTasks > 0 && m_queue.dequeue(task)) {
+            --m_priorityTasks;
+            return true;
+        }
+        Task* t = m_deques[index]->take();
+        if (!t) t = takeInjected(index);
+        if (!t) t = steal(index);
+        if (!t) return false;
+        task = std::move(*t);
+        delete t;
+        return true;
+    }
+
+    // 取走一个任务，并把注入队列中的一部分任务移到自己的队列中，减少注入队列的加锁次数
+    Task* takeInjected(int index) {
+        std::lock_guard<std::mutex> lock(m_injectMutex);
+        if (m_inject.empty()) return nullptr;
+        Task* t = m_inject.front();
+        m_inject.pop_front();
+        size_t batch = std::min((m_inject.size() + 1) / 2, (size_t)INJECT_BATCH - 1);
+        for (size_t i = 0; i < batch; ++i) {
+            m_deques[index]->push(m_inject.front());
+            m_inject.pop_front();
+        }
+        return t;
+    }
+
+    Task* steal(int index) {
+        WorkerContext& ctx = currentWorker();
+        // xorshift，从随机的线程开始，避免所有空闲线程同时窃取同一个队列
+        ctx.seed ^= ctx.seed << 13;
+        ctx.seed ^= ctx.seed >> 17;
+        ctx.seed ^= ctx.seed << 5;
+        size_t n = m_deques.size();
+        size_t start = ctx.seed % n;
+        for (size_t i = 0; i < n; ++i) {
+            size_t victim = (start + i) % n;
+            if ((int)victim == index) continue;
+            Task* t = m_deques[victim]->steal();
+            if (t) return t;
+        }
+        return nullptr;
+    }
+
+    void stealingLoop(int index) {
+        WorkerContext& ctx = currentWorker();
+        ctx.pool = this;
+        ctx.index = index;
+        ctx.seed = index * 2654435761u + 1;
+
+        Task t;
+        int idle = 0;
+        while (true) {
+            if (findTask(index, t)) {
+                idle = 0;
+                --m_pending;
+                runTask(t);
+                continue;
+            }
+            // 没有任务时先让出几次CPU再睡眠，连续提交的任务不需要每次都唤醒线程
+            if (idle++ < STEAL_SPINS) {
+                std::this_thread::yield();
+                continue;
+            }
+            idle = 0;
+
+            std::unique_lock<std::mutex> lock(m_conditional_mutex);
+            ++m_sleepers;
+            m_conditional_lock.wait(lock, [this] { return m_pending > 0 || m_shutdown || m_shrink > 0; });
+            --m_sleepers;
+            // 任务可能在其它线程的队列中，回去窃取
+            if (m_pending > 0) continue;
+            if (m_shutdown) break;
+            int shrink = m_shrink;
+            if (shrink > 0 && m_shrink.compare_exchange_strong(shrink, shrink - 1)) {
+                lock.unlock();
+                retireWorker(index);
+                break;
+            }
+        }
+        ctx.pool = nullptr;
+    }
+
+    // 工作窃取模式按双端队列下标绑定，线程退出后新线程使用同一个CPU
+    void pinWorker(int index) {
+        if (m_cpus.empty()) return;
+        unsigned int slot = index >= 0 ? (unsigned int)index : m_nextCpu++;
+        affinity::pinThread(m_cpus[slot % m_cpus.size()]);
+    }
+
+    void ringLoop() {
+        Task t;
+        int idle = 0;
+        while (true) {
+            if (!popRing(t)) {
+                if (idle++ < STEAL_SPINS) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                idle = 0;
+                // 先登记等待再检查一次，提交方在登记之后入队时一定会唤醒
+                uint32_t key = m_taskEvent.prepareWait();
+                if (!popRing(t)) {
+                    if (m_shutdown) {
+                        m_taskEvent.cancelWait();
+                        break;
+                    }
+                    int shrink = m_shrink;
+                    if (shrink > 0 && m_shrink.compare_exchange_strong(shrink, shrink - 1)) {
+                        m_taskEvent.cancelWait();
+                        retireWorker(-1);
+                        break;
+                    }
+                    m_taskEvent.wait(key);
+                    continue;
+                }
+                m_taskEvent.cancelWait();
+            }
+            runTask(t);
+        }
+    }
+
+    bool popRing(Task& task) {
+        if (m_priorityTasks > 0 && m_queue.dequeue(task)) {
+            --m_priorityTasks;
+            return true;
+        }
+        if (m_ring->tryPop(task)) return true;
+        // 溢出的任务都比环形队列中剩下的任务晚提交
+        if (m_overflowTasks == 0) return false;
+        std::lock_guard<std::mutex> lock(m_overflowMutex);
+        if (m_overflow.empty()) return false;
+        task = std::move(m_overflow.front());
+        m_overflow.pop_front();
+        --m_overflowTasks;
+        return true;
+    }
+
+    // 收缩时空闲线程从线程列表中移除自己，双端队列此时为空，下标留给新线程
+    void retireWorker(int index) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        std::thread::id this_id = std::this_thread::get_id();
+        if (mp.count(this_id))
+        {
+            // 正在运行的线程对象不能直接析构
+            mp[this_id]->detach();
+            lst_threads.erase(mp[this_id]);
+            mp.erase(this_id);
+            --sleep_nums;
+        }
+        if (index >= 0) {
+            m_freeSlots.push_back(index);
+        }
+    }
+
+    size_t queuedTasks() {
+        if (m_mode == WORK_STEALING) return m_pending;
+        if (m_mode == LOCK_FREE_QUEUE) return m_ring->size() + m_priorityTasks + m_overflowTasks;
+        return m_queue.size();
+    }
+
+    void addThreads(size_t n) {
+        for (size_t i = 0; i < n; ++i)
+        {
+            int index = -1;
+            if (m_mode == WORK_STEALING) {
+                if (m_freeSlots.empty()) break;
+                index = m_freeSlots.back();
+                m_freeSlots.pop_back();
+            }
+            auto it = lst_threads.emplace(lst_threads.end(), std::thread(ThreadWorker(this, index)));
+            mp[it->get_id()] = it;
+            ++sleep_nums;
+        }
+    }
+
+    void removeThreads(size_t n) {
+        if (m_mode == LOCK_FREE_QUEUE) {
+            m_shrink += n;
+            m_taskEvent.notifyAll();
+            return;
+        }
+        std::lock_guard<std::mutex> cond_lock(m_conditional_mutex);
+        m_shrink += n;
+        m_conditional_lock.notify_all();
+    }
+
+    /*
+    根据上一个周期的平均排队时间和利用率调整线程数
+    排队时间超过目标时立即扩容，最多翻倍；队列中有任务却没有任务出队，说明所有线程都被长任务占住，排队时间按一个周期计算
+    排队时间不到目标的一半并且利用率低时，连续shrinkTicks个周期才缩容，每次去掉多余线程的一半
+    */
     void resizePool() {
+        int64_t now = nowUs();
+        double interval = std::max<int64_t>(now - m_lastTick, 1);
+        m_lastTick = now;
+        int64_t waitSum = m_waitSum.exchange(0);
+        int64_t waitCount = m_waitCount.exchange(0);
+        int64_t busyTime = m_busyTime.exchange(0);
+
         std::unique_lock<std::mutex> lock(m_mutex);
-        size_t task_num = m_queue.size();
+        if (m_shutdown) return;
+        size_t queued = queuedTasks();
         size_t cur_threads = lst_threads.size();
+        if (cur_threads == 0) return;
+
+        double wait = waitCount > 0 ? (double)waitSum / waitCount : 0;
+        if (queued > 0 && waitCount == 0) {
+            wait = interval;
+        }
+        // 执行时间在任务结束时才统计，同时参考当前正在执行的线程数
+        double utilization = std::max(busyTime / (interval * cur_threads), (double)work_nums / cur_threads);
+        utilization = std::min(utilization, 1.0);
+        m_stats.waitUs = wait;
+        m_stats.utilization = utilization;
 
         // 扩展线程池
-        if (task_num > work_nums && cur_threads < max_threads)
+        if (wait > m_tuning.targetWaitUs && queued > 0 && cur_threads < max_threads)
         {
-            size_t add_threads = std::min(max_threads - cur_threads, task_num - work_nums);
-            for (size_t i = 0; i < add_threads; ++i)
-            {
-                auto it = lst_threads.emplace(lst_threads.end(), std::thread(ThreadWorker(this)));
-                mp[it->get_id()] = it;
-                ++sleep_nums;
-            }
-            LOG_INFO("Add thread nums: %d", add_threads);
+            size_t add_threads = std::min(max_threads - cur_threads, std::max<size_t>(1, std::min(queued, cur_threads)));
+            addThreads(add_threads);
+            m_idleTicks = 0;
+            ++m_stats.grows;
+            LOG_INFO("Add thread nums: %zu, queue wait %.0f us, utilization %.2f", add_threads, wait, utilization);
             return;
         }
 
         // 收缩线程池
-        if (work_nums < sleep_nums && cur_threads > min_threads)
+        if (wait < m_tuning.targetWaitUs / 2 && utilization < m_tuning.lowUtilization && cur_threads > min_threads)
         {
-            size_t remove_threads = cur_threads - std::max(2 * task_num, (size_t)min_threads);
-            size_t temp = std::min((size_t)sleep_nums, cur_threads - min_threads);
-            remove_threads = std::min(temp, remove_threads);
-
-            for (size_t i = 0; i < remove_threads; ++i)
-            {
-                m_conditional_lock.notify_one();
-            }
-            LOG_INFO("Remove thread nums: %d", remove_threads);
+            if (++m_idleTicks < m_tuning.shrinkTicks) return;
+            m_idleTicks = 0;
+            // 保留当前繁忙程度两倍的线程
+            size_t needed = std::max(min_threads, (size_t)(utilization * cur_threads * 2) + 1);
+            if (needed >= cur_threads) return;
+            size_t remove_threads = std::max<size_t>(1, (cur_threads - needed) / 2);
+            removeThreads(remove_threads);
+            ++m_stats.shrinks;
+            LOG_INFO("Remove thread nums: %zu, queue wait %.0f us, utilization %.2f", remove_threads, wait, utilization);
             return;
         }
+        m_idleTicks = 0;
     }
 
     void timer_function() {
+        std::unique_lock<std::mutex> lock(m_timerMutex);
         while (!m_shutdown) {
-            std::this_thread::sleep_for(timer_interval);
+            m_timerCond.wait_for(lock, timer_interval, [this] { return (bool)m_shutdown; });
+            if (m_shutdown) break;
+            lock.unlock();
             resizePool();
+            lock.lock();
         }
     }
 };
\ No newline at end of file
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+
+/*
+Chase-Lev工作窃取双端队列（按照Lê等人的C11内存模型版本实现）
+只有所属线程可以push和take，在底部操作，后进先出，刚提交的任务数据还在缓存中
+其它线程通过steal从顶部取走最早的任务，只需要一次CAS
+元素必须是指针，空队列时返回nullptr
+数组满时扩容为两倍，旧数组在队列析构时才释放，因为窃取者可能还在读取
+*/
+template <typename T>
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(size_t capacity = 256);
+    ~WorkStealingDeque();
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // 只能由所属线程调用
+    void push(T item);
+    T take();
+    // 任意线程调用，和其它窃取者或者所属线程冲突时返回nullptr
+    T steal();
+
+    bool empty() const { return size() == 0; }
+    // 并发时只是近似值
+    size_t size() const {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+private:
+    struct Array {
+        int64_t mask;
+        std::atomic<T>* slots;
+
+        explicit Array(int64_t capacity) : mask(capacity - 1), slots(new std::atomic<T>[capacity]) {}
+        ~Array() { delete[] slots; }
+
+        int64_t capacity() const { return mask + 1; }
+        T get(int64_t i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T item) { slots[i & mask].store(item, std::memory_order_relaxed); }
+    };
+
+    Array* grow(Array* old, int64_t bottom, int64_t top);
+
+    // top和bottom分别由窃取者和所属线程修改，放在不同的缓存行中
+    alignas(64) std::atomic<int64_t> m_top;
+    alignas(64) std::atomic<int64_t> m_bottom;
+    alignas(64) std::atomic<Array*> m_array;
+    // 只由所属线程访问
+    std::vector<Array*> m_retired;
+};
+
+
+template <typename T>
+WorkStealingDeque<T>::WorkStealingDeque(size_t capacity) : m_top(0), m_bottom(0)
+{
+    // 容量取2的幂
+    int64_t cap = 2;
+    while (cap < static_cast<int64_t>(capacity)) cap <<= 1;
+    m_array.store(new Array(cap), std::memory_order_relaxed);
+}
+
+template <typename T>
+WorkStealingDeque<T>::~WorkStealingDeque()
+{
+    for (Array* a : m_retired) {
+        delete a;
+    }
+    delete m_array.load(std::memory_order_relaxed);
+}
+
+template <typename T>
+void WorkStealingDeque<T>::push(T item)
+{
+    int64_t b = m_bottom.load(std::memory_order_relaxed);
+    int64_t t = m_top.load(std::memory_order_acquire);
+    Array* a = m_array.load(std::memory_order_relaxed);
+    if (b - t > a->capacity() - 1) {
+        a = grow(a, b, t);
+    }
+    a->put(b, item);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+template <typename T>
+T WorkStealingDeque<T>::take()
+{
+    int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+    Array* a = m_array.load(std::memory_order_relaxed);
+    m_bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = m_top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        // 队列为空
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    T item = a->get(b);
+    if (t == b) {
+        // 最后一个元素，和窃取者竞争
+        if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            item = nullptr;
+        }
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+}
+
+template <typename T>
+T WorkStealingDeque<T>::steal()
+{
+    int64_t t = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = m_bottom.load(std::memory_order_acquire);
+    if (t >= b) {
+        return nullptr;
+    }
+    Array* a = m_array.load(std::memory_order_acquire);
+    T item = a->get(t);
+    if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return item;
+}
+
+template <typename T>
+typename WorkStealingDeque<T>::Array* WorkStealingDeque<T>::grow(Array* old, int64_t bottom, int64_t top)
+{
+    Array* a = new Array(old->capacity() * 2);
+    for (int64_t i = top; i < bottom; ++ i) {
+        a->put(i, old->get(i));
+    }
+    m_retired.push_back(old);
+    m_array.store(a, std::memory_order_release);
+    return a;
+}
@@ -0,0 +1,488 @@
+#include "server/eventLoop.h"
+
+EventLoop::EventLoop(ObjectPool<HttpConnect>* objectPool, ThreadPool* threadPool, int timeoutMS, uint32_t connEvent,
+                     int maxFd, PollerType pollerType):
+                    m_objectPool(objectPool), m_ownPool(false), m_threadPool(threadPool), m_timer(nullptr),
+                    m_epoller(Poller::newPoller(pollerType)), m_uring(nullptr),
+                    m_timeoutMS(timeoutMS), m_connEvent(connEvent), m_userCount(0), m_users(maxFd), m_listenFd(-1), m_quit(false), m_cpu(-1)
+{
+    m_timer = new TimingWheel(std::bind(&EventLoop::onTimeout, this, std::placeholders::_1));
+    m_wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    assert(m_wakeupFd >= 0);
+    m_epoller->addFd(m_wakeupFd, EPOLLIN);
+    // 线程池中的读写基于就绪通知，只有从reactor使用完成模式
+    if (threadPool == nullptr && pollerType == IO_URING) {
+        UringPoller* uring = dynamic_cast<UringPoller*>(m_epoller);
+        if (uring != nullptr && uring->enableCompletion()) {
+            m_uring = uring;
+        }
+    }
+}
+
+EventLoop::~EventLoop()
+{
+    stop();
+    close(m_wakeupFd);
+    delete m_epoller;
+    delete m_timer;
+    if (m_ownPool) {
+        delete m_objectPool;
+    }
+}
+
+void EventLoop::loopOnce()
+{
+    // 先处理到期的连接，再最多等待到下一个定时器需要处理的时间，没有定时器时返回-1，一直等待
+    int timeMS = m_timer->GetNextTick();
+    int eventCount = m_epoller->wait(timeMS);
+    // 每次迭代只读取一次时钟，定时器、日志和响应头都使用这个时间
+    CachedClock::update();
+    for (int i = 0; i < eventCount; ++ i) {
+        if (m_uring != nullptr) {
+            const Completion* c = m_uring->getCompletion(i);
+            if (c != nullptr) {
+                handleCompletion(*c);
+                continue;
+            }
+        }
+        int fd = m_epoller->getEventFd(i);
+        uint32_t events = m_epoller->getEvents(i);
+        if (fd == m_listenFd) {
+            m_listenCallback();
+            continue;
+        } else if (fd == m_wakeupFd) {
+            handleWakeup();
+            continue;
+        }
+
+        HttpConnect* client = m_users.get(fd);
+        if (client == nullptr) {
+            LOG_WARN("Event on closed fd[%d]: events = 0x%x", fd, events);
+            continue;
+        }
+        uint32_t gen = m_users.generation(fd);
+        if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            closeConn(std::string("Epoll cause close."), fd, gen);
+        } else if (events & EPOLLIN) {
+            dealRead(client, gen);
+        } else if (events & EPOLLOUT) {
+            dealWrite(client, gen);
+        } else {
+            LOG_ERROR("Unexpected event on fd[%d]: events = 0x%x", fd, events);
+        }
+    }
+    // 一次唤醒只提交一次，只唤醒需要的工作线程
+    if (!m_tasks.empty()) {
+        m_threadPool->submitBatch(m_tasks.data(), m_tasks.size());
+        m_tasks.clear();
+    }
+}
+
+void EventLoop::setCpu(int cpu, std::function<ObjectPool<HttpConnect>*()> makePool)
+{
+    assert(!m_thread.joinable());
+    m_cpu = cpu;
+    m_makePool = std::move(makePool);
+}
+
+// 循环开始之前还没有连接，可以在本线程中重新创建时间轮和对象池
+void EventLoop::initOnCpu()
+{
+    if (m_cpu < 0 || !affinity::pinThread(m_cpu)) return;
+    delete m_timer;
+    m_timer = new TimingWheel(std::bind(&EventLoop::onTimeout, this, std::placeholders::_1));
+    if (m_makePool) {
+        m_objectPool = m_makePool();
+        m_ownPool = true;
+    }
+    LOG_INFO("Event loop pinned to cpu %d, numa node %d", m_cpu, affinity::numaNode(m_cpu));
+}
+
+void EventLoop::start()
+{
+    assert(!m_thread.joinable());
+    m_thread = std::thread([this]() {
+        initOnCpu();
+        // 信号只交给主线程处理，保证SIGINT能够打断主循环的epoll_wait
+        sigset_t mask;
+        sigfillset(&mask);
+        pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+        while (!m_quit) {
+            loopOnce();
+        }
+    });
+}
+
+void EventLoop::stop()
+{
+    m_quit = true;
+    if (m_thread.joinable()) {
+        wakeup();
+        m_thread.join();
+    }
+}
+
+bool EventLoop::setListen(int listenFd, uint32_t listenEvent, std::function<void()> cb,
+                          std::function<void(int)> onAccept)
+{
+    m_listenFd = listenFd;
+    m_listenCallback = std::move(cb);
+    if (m_uring != nullptr && onAccept) {
+        m_acceptCallback = std::move(onAccept);
+        return m_uring->acceptMulti(listenFd);
+    }
+    return m_epoller->addFd(listenFd, listenEvent | EPOLLIN);
+}
+
+void EventLoop::addClient(int fd, const sockaddr_in& addr)
+{
+    assert(fd > 0);
+    if (static_cast<size_t>(fd) >= m_users.capacity()) {
+        LOG_WARN("Client[%d] exceeds MAX_FD, refused", fd);
+        close(fd);
+        return;
+    }
+    // 连接对象达到上限时立即拒绝，不能阻塞事件循环
+    auto obj = m_objectPool->acquireObject();
+    if (obj == nullptr) {
+        LOG_WARN("Client[%d] refused, connection objects are exhausted", fd);
+        sendError(fd, "Server busy!");
+        return;
+    }
+    obj->init(fd, addr);
+    uint32_t gen = m_users.insert(fd, obj);
+    ++ m_userCount;
+    if (m_timeoutMS > 0) {
+        obj->m_timerNode.data = (static_cast<uint64_t>(gen) << 32) | static_cast<uint32_t>(fd);
+        m_timer->add(&obj->m_timerNode, m_timeoutMS);
+    }
+    setFdNonBlock(fd);
+    if (m_uring != nullptr) {
+        m_uring->recvMulti(fd, gen);
+    } else {
+        // 设置读事件到来的epoll触发
+        m_epoller->addFd(fd, EPOLLIN | m_connEvent);
+    }
+    LOG_INFO("Client[%d] in!", fd);
+}
+
+void EventLoop::queueClient(int fd, const sockaddr_in& addr)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMtx);
+        m_pending.emplace_back(fd, addr);
+    }
+    wakeup();
+}
+
+void EventLoop::sendError(int fd, const char *info)
+{
+    assert(fd > 0);
+    int ret = send(fd, info, strlen(info), 0);
+    if (ret < 0) {
+        LOG_WARN("Send error to client[%d] error!", fd);
+    }
+    close(fd);
+}
+
+int EventLoop::setFdNonBlock(int fd)
+{
+    assert(fd > 0);
+    return fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+void EventLoop::wakeup()
+{
+    uint64_t one = 1;
+    if (::write(m_wakeupFd, &one, sizeof(one)) != sizeof(one)) {
+        LOG_WARN("Wakeup event loop error!");
+    }
+}
+
+void EventLoop::handleWakeup()
+{
+    uint64_t count;
+    while (::read(m_wakeupFd, &count, sizeof(count)) > 0) {}
+
+    std::vector<std::pair<int, sockaddr_in>> pending;
+    std::vector<PendingClose> closing;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMtx);
+        pending.swap(m_pending);
+        closing.swap(m_closing);
+    }
+    for (auto& client : pending) {
+        addClient(client.first, client.second);
+    }
+    for (auto& c : closing) {
+        closeConn(c.reason, c.fd, c.gen);
+    }
+}
+
+void EventLoop::extentTime(HttpConnect *client)
+{
+    assert(client);
+    if (m_timeoutMS > 0) {
+        m_timer->add(&client->m_timerNode, m_timeoutMS);
+    }
+}
+
+void EventLoop::onTimeout(WheelNode* node)
+{
+    int fd = static_cast<int>(node->data & 0xffffffff);
+    uint32_t gen = static_cast<uint32_t>(node->data >> 32);
+    // 线程池正在处理的连接不是空闲连接，重新计时；完成模式下发送不出去的连接照常超时
+    HttpConnect* client = m_users.get(fd, gen);
+    if (m_threadPool != nullptr && client != nullptr
+        && (client->m_inFlight.load(std::memory_order_acquire) & ~INFLIGHT_CLOSE_PENDING) > 0) {
+        m_timer->add(node, m_timeoutMS);
+        return;
+    }
+    closeConn(std::string("Timer cause client close"), fd, gen);
+}
+
+void EventLoop::closeConn(const std::string& message, int fd, uint32_t gen)
+{
+    // 定时器回调或线程池的关闭请求到达时连接可能已经被关闭，fd甚至已经分配给了新的连接，只有代数匹配才能释放
+    HttpConnect* client = m_users.get(fd, gen);
+    if (client == nullptr) return;
+    // 完成模式下先取消还在进行的发送，最后一个发送完成时再关闭
+    if (m_uring != nullptr && client->m_inFlight.load(std::memory_order_relaxed) > 0) {
+        if (!client->m_closing) {
+            LOG_DEBUG("Client[%d] closing: %s", fd, message.c_str());
+            client->m_closing = true;
+            m_uring->cancel(fd, gen);
+        }
+        return;
+    }
+    // 工作线程重新注册事件之后、交还连接之前，事件循环可能已经收到了这个连接的事件
+    // 只标记关闭，由最后交还连接的任务请求关闭，不在事件循环里反复重试
+    if (m_threadPool != nullptr) {
+        int inFlight = client->m_inFlight.fetch_or(INFLIGHT_CLOSE_PENDING, std::memory_order_acq_rel);
+        if ((inFlight & ~INFLIGHT_CLOSE_PENDING) > 0) {
+            if (!(inFlight & INFLIGHT_CLOSE_PENDING)) {
+                LOG_DEBUG("Client[%d] closing: %s", fd, message.c_str());
+            }
+            return;
+        }
+    }
+    if (m_users.release(fd, gen) == nullptr) return;
+    // 调试使用
+    LOG_INFO("Client[%d] quit, the quit reason is: %s", fd, message.c_str());
+    m_timer->del(&client->m_timerNode);
+    if (m_uring != nullptr) {
+        // multishot recv持有套接字的引用，取消之后套接字才真正关闭
+        m_uring->cancel(fd, gen);
+    } else {
+        m_epoller->delFd(fd);
+    }
+    client->closeClient();
+    client->m_isClosed = true;
+    client->clearResource();
+    client->m_inFlight.store(0, std::memory_order_relaxed);
+    m_objectPool->releaseObject(client);
+    -- m_userCount;
+}
+
+void EventLoop::queueClose(const std::string& message, int fd, uint32_t gen)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMtx);
+        m_closing.push_back({fd, gen, message});
+    }
+    wakeup();
+}
+
+void EventLoop::rearm(HttpConnect* client, uint32_t gen, uint32_t events)
+{
+    // 连接由本任务持有，不会被关闭，代数一定匹配
+    int fd = client->getFd();
+    if (m_threadPool == nullptr) {
+        m_epoller->modFd(fd, m_connEvent | events);
+        return;
+    }
+    // 事件循环已经要求关闭时不再注册事件
+    if (!(client->m_inFlight.load(std::memory_order_acquire) & INFLIGHT_CLOSE_PENDING)) {
+        m_epoller->modFd(fd, m_connEvent | events);
+    }
+    if (client->m_inFlight.fetch_sub(1, std::memory_order_acq_rel) == (INFLIGHT_CLOSE_PENDING | 1)) {
+        queueClose(std::string("Closed after the worker handed it back"), fd, gen);
+    }
+}
+
+void EventLoop::requestClose(const std::string& message, HttpConnect* client, uint32_t gen)
+{
+    int fd = client->getFd();
+    if (m_threadPool == nullptr) {
+        closeConn(message, fd, gen);
+        return;
+    }
+    // 先交还连接再请求关闭，事件循环收到请求时连接已经不在线程池中
+    client->m_inFlight.fetch_sub(1, std::memory_order_release);
+    queueClose(message, fd, gen);
+}
+
+void EventLoop::dealRead(HttpConnect *client, uint32_t gen)
+{
+    assert(client);
+    extentTime(client);
+    if (m_threadPool == nullptr) {
+        onRead(client, gen);
+        return;
+    }
+    client->m_inFlight.fetch_add(1, std::memory_order_relaxed);
+    m_tasks.emplace_back([this, client, gen]() { onRead(client, gen); });
+}
+
+void EventLoop::dealWrite(HttpConnect *client, uint32_t gen)
+{
+    assert(client);
+    extentTime(client);
+    if (m_threadPool == nullptr) {
+        onWrite(client, gen);
+        return;
+    }
+    client->m_inFlight.fetch_add(1, std::memory_order_relaxed);
+    m_tasks.emplace_back([this, client, gen]() { onWrite(client, gen); });
+}
+
+void EventLoop::onProcess(HttpConnect *client, uint32_t gen)
+{
+    rearm(client, gen, client->process() ? EPOLLOUT : EPOLLIN);
+}
+
+void EventLoop::onRead(HttpConnect *client, uint32_t gen)
+{
+    assert(client);
+    int ret = -1;
+    int readErrno = 0;
+    ret = client->read(&readErrno);
+    if (ret <= 0 && readErrno != EAGAIN) {
+        requestClose(std::string("Read Error cause client close."), client, gen);
+        return;
+    }
+    onProcess(client, gen);
+}
+
+void EventLoop::onWrite(HttpConnect *client, uint32_t gen)
+{
+    assert(client);
+    int ret = -1;
+    int writeErrno = 0;
+    ret = client->write(&writeErrno);
+    if (client->toWriteBytes() == 0) {
+        if (client->isKeepAlive()) {
+            // 读缓冲区中可能还有没处理完的流水线请求
+            onProcess(client, gen);
+            return;
+        }
+    } else if (ret < 0) {
+        // 继续传输
+        if (writeErrno == EAGAIN) {
+            rearm(client, gen, EPOLLOUT);
+            return;
+        }
+    }
+    requestClose(std::string("Write error cause client close"), client, gen);
+}
+
+void EventLoop::handleCompletion(const Completion& c)
+{
+    switch (c.type) {
+    case COMPLETION_ACCEPT:
+        onAccept(c);
+        break;
+    case COMPLETION_RECV:
+        onRecv(c);
+        break;
+    case COMPLETION_SEND:
+        onSent(c);
+        break;
+    default:
+        LOG_ERROR("Unexpected completion on fd[%d]: type = %d", c.fd, c.type);
+    }
+}
+
+void EventLoop::onAccept(const Completion& c)
+{
+    if (c.res >= 0) {
+        m_acceptCallback(c.res);
+    } else if (c.res != -ECANCELED) {
+        LOG_WARN("Accept error: %s", strerror(-c.res));
+    }
+    if (!c.more) {
+        m_uring->acceptMulti(m_listenFd);
+    }
+}
+
+void EventLoop::onRecv(const Completion& c)
+{
+    // 连接已经关闭或者正在关闭，收到的数据直接丢弃，缓冲区由poller回收
+    HttpConnect* client = m_users.get(c.fd, c.gen);
+    if (client == nullptr || client->m_closing) return;
+    if (c.res <= 0) {
+        // 接收缓冲区暂时用完，下一次wait归还缓冲区之后重新提交
+        if (c.res == -ENOBUFS) {
+            m_uring->recvMulti(c.fd, c.gen);
+            return;
+        }
+        closeConn(std::string(c.res == 0 ? "Peer closed." : "Read Error cause client close."), c.fd, c.gen);
+        return;
+    }
+    extentTime(client);
+    client->received(c.data, c.res);
+    if (!c.more) {
+        m_uring->recvMulti(c.fd, c.gen);
+    }
+    // 上一批响应还在发送时先积累请求，发送完之后再处理
+    if (client->m_inFlight.load(std::memory_order_relaxed) == 0) {
+        sendResponse(client, c.gen);
+    }
+}
+
+void EventLoop::onSent(const Completion& c)
+{
+    HttpConnect* client = m_users.get(c.fd, c.gen);
+    if (client == nullptr) return;
+    client->m_inFlight.fetch_sub(1, std::memory_order_relaxed);
+    ChainBuffer& buff = client->writeBuffer();
+    if (c.res > 0) {
+        buff.retrieve(c.res);
+    } else if (c.res != -ECANCELED) {
+        // 链接中前一个请求没有发送完时后面的请求以-ECANCELED完成，剩下的数据重新提交
+        client->m_closing = true;
+    }
+    // 等链接在一起的请求全部完成
+    if (client->m_inFlight.load(std::memory_order_relaxed) > 0) return;
+
+    if (client->m_closing) {
+        closeConn(std::string("Write error cause client close"), c.fd, c.gen);
+    } else if (buff.readAbleBytes() > 0) {
+        submitSend(client, c.gen);
+    } else if (!client->isKeepAlive()) {
+        closeConn(std::string("Response sent, connection is not keep-alive"), c.fd, c.gen);
+    } else {
+        // 读缓冲区中可能还有没处理完的流水线请求
+        extentTime(client);
+        sendResponse(client, c.gen);
+    }
+}
+
+void EventLoop::sendResponse(HttpConnect* client, uint32_t gen)
+{
+    if (client->process()) {
+        submitSend(client, gen);
+    }
+}
+
+void EventLoop::submitSend(HttpConnect* client, uint32_t gen)
+{
+    m_iov.clear();
+    client->writeBuffer().peek(m_iov);
+    int count = m_iov.empty() ? 0 : m_uring->sendMsg(client->getFd(), gen, m_iov.data(), m_iov.size());
+    if (count == 0) {
+        closeConn(std::string("Write error cause client close"), client->getFd(), gen);
+        return;
+    }
+    client->m_inFlight.fetch_add(count, std::memory_order_relaxed);
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+
+#include "pool/objectPool.h"
+#include "pool/threadPool.h"
+#include "http/httpConnect.h"
+#include "timer/timingWheel.h"
+#include "log/log.h"
+#include "poller.h"
+#include "uringPoller.h"
+#include "slotTable.h"
+#include "util/affinity.h"
+
+/*
+一个EventLoop拥有自己的epoll实例、时间轮和连接表，连接从加入到关闭都只属于一个EventLoop
+threadPool不为空时，读写交给线程池完成（单reactor模式，使用reactor模拟proactor）
+    交给线程池的连接由工作线程持有，直到重新注册事件或者请求关闭，期间事件循环不会关闭它
+    连接只在事件循环线程中关闭，时间轮和连接表不会被工作线程修改
+threadPool为空时，读写直接在事件循环所在的线程中完成（主从reactor模式中的从reactor）
+    后端是io_uring时使用完成模式：multishot accept和multishot recv持续收取数据，响应用sendmsg提交，
+    收发都不再需要每次一个系统调用，连接在所有发送请求完成之前不会被关闭
+*/
+class EventLoop {
+public:
+    EventLoop(ObjectPool<HttpConnect>* objectPool, ThreadPool* threadPool, int timeoutMS, uint32_t connEvent,
+              int maxFd, PollerType pollerType = EPOLL);
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    void loopOnce();
+    // 在start之前调用，循环线程绑定到cpu上
+    // makePool不为空时由循环线程在绑核之后创建自己的连接对象池，连接对象和缓冲区都分配在本地NUMA节点上
+    void setCpu(int cpu, std::function<ObjectPool<HttpConnect>*()> makePool = nullptr);
+    void start();
+    void stop();
+
+    // 监听套接字的可读事件交给回调处理
+    // 完成模式下onAccept不为空时改用multishot accept，新连接的fd直接交给onAccept
+    bool setListen(int listenFd, uint32_t listenEvent, std::function<void()> cb,
+                   std::function<void(int)> onAccept = nullptr);
+    void addClient(int fd, const sockaddr_in& addr);
+    // 可以在其它线程调用，连接会在本循环的线程中加入
+    void queueClient(int fd, const sockaddr_in& addr);
+    size_t userCount() const {return m_userCount;}
+    bool completionMode() const {return m_uring != nullptr;}
+
+    static int setFdNonBlock(int fd);
+    // 拒绝连接：发送错误信息后关闭
+    static void sendError(int fd, const char* info);
+
+private:
+    ObjectPool<HttpConnect>* m_objectPool;
+    bool m_ownPool;
+    ThreadPool* m_threadPool;
+    TimingWheel* m_timer;
+    Poller* m_epoller;
+    // 完成模式下指向m_epoller，否则为空
+    UringPoller* m_uring;
+
+    int m_timeoutMS;
+    uint32_t m_connEvent;
+    std::atomic<size_t> m_userCount;
+    SlotTable<HttpConnect> m_users;
+
+    int m_listenFd;
+    std::function<void()> m_listenCallback;
+    std::function<void(int)> m_acceptCallback;
+    // 提交发送请求时使用的iovec，poller会复制一份
+    std::vector<iovec> m_iov;
+
+    // 其它线程通过eventfd唤醒本循环，取走待加入的连接
+    int m_wakeupFd;
+    std::mutex m_pendingMtx;
+    std::vector<std::pair<int, sockaddr_in>> m_pending;
+    // 线程池中请求关闭的连接，由本循环的线程关闭
+    struct PendingClose {
+        int fd;
+        uint32_t gen;
+        std::string reason;
+    };
+    std::vector<PendingClose> m_closing;
+
+    // 一次迭代中交给线程池的读写任务，迭代结束时一起提交
+    std::vector<TaskFunc> m_tasks;
+
+    std::atomic<bool> m_quit;
+    std::thread m_thread;
+    int m_cpu;
+    std::function<ObjectPool<HttpConnect>*()> m_makePool;
+
+    void initOnCpu();
+
+    void wakeup();
+    void handleWakeup();
+    void extentTime(HttpConnect* client);
+    void onTimeout(WheelNode* node);
+
+    // gen是连接加入时的代数，连接已经关闭或fd被复用时这些调用什么也不做
+    // 只能在事件循环线程中调用，连接还在线程池中时推迟到交还之后
+    void closeConn(const std::string& message, int fd, uint32_t gen);
+    void queueClose(const std::string& message, int fd, uint32_t gen);
+    // 读写任务结束时调用，重新注册事件或者请求关闭，同时把连接交还给事件循环，之后不能再访问client
+    void rearm(HttpConnect* client, uint32_t gen, uint32_t events);
+    void requestClose(const std::string& message, HttpConnect* client, uint32_t gen);
+    void dealRead(HttpConnect* client, uint32_t gen);
+    void dealWrite(HttpConnect* client, uint32_t gen);
+    void onProcess(HttpConnect* client, uint32_t gen);
+    void onRead(HttpConnect* client, uint32_t gen);
+    void onWrite(HttpConnect* client, uint32_t gen);
+
+    // 完成模式
+    void handleCompletion(const Completion& c);
+    void onAccept(const Completion& c);
+    void onRecv(const Completion& c);
+    void onSent(const Completion& c);
+    // 处理读缓冲区中完整的请求并提交响应
+    void sendResponse(HttpConnect* client, uint32_t gen);
+    void submitSend(HttpConnect* client, uint32_t gen);
+};
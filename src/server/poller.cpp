@@ -0,0 +1,17 @@
+#include "server/poller.h"
+#include "server/epoller.h"
+#include "server/uringPoller.h"
+#include "log/log.h"
+
+Poller* Poller::newPoller(PollerType type, int maxEvent)
+{
+    if (type == IO_URING) {
+        UringPoller* poller = new UringPoller(maxEvent);
+        if (poller->valid()) {
+            return poller;
+        }
+        delete poller;
+        LOG_WARN("io_uring is not available, fall back to epoll");
+    }
+    return new Epoller(maxEvent);
+}
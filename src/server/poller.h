@@ -0,0 +1,29 @@
+#pragma once
+#include <sys/epoll.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// 事件循环可以选择的IO多路复用后端
+enum PollerType {
+    EPOLL,
+    IO_URING,
+};
+
+/*
+IO多路复用的统一接口，事件使用epoll的标志位（EPOLLIN、EPOLLOUT、EPOLLONESHOT等）表示
+不同的后端需要保证和epoll相同的语义，事件循环不需要关心具体使用的是哪一种后端
+*/
+class Poller {
+public:
+    virtual ~Poller() = default;
+
+    virtual bool addFd(int fd, uint32_t events) = 0;
+    virtual bool modFd(int fd, uint32_t events) = 0;
+    virtual bool delFd(int fd) = 0;
+    virtual int wait(int timeoutMs = -1) = 0;
+    virtual int getEventFd(size_t i) const = 0;
+    virtual uint32_t getEvents(size_t i) const = 0;
+
+    // io_uring创建失败（内核不支持或被禁用）时退回epoll
+    static Poller* newPoller(PollerType type, int maxEvent = 1024);
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include <assert.h>
+
+/*
+以fd为下标的连接表，构造时按最大fd数量一次性分配，查找不需要哈希也不需要分配结点
+每个槽位带一个代数，fd每次被占用或释放时代数加一
+定时器回调和线程池任务保存(fd, 代数)，执行时代数不一致说明连接已经关闭或fd已被复用
+*/
+template <typename T>
+class SlotTable {
+public:
+    explicit SlotTable(size_t maxFd): m_slots(maxFd) {}
+
+    SlotTable(const SlotTable&) = delete;
+    SlotTable& operator=(const SlotTable&) = delete;
+
+    size_t capacity() const {return m_slots.size();}
+
+    // 返回新占用的代数
+    uint32_t insert(int fd, T* obj);
+    T* get(int fd) const;
+    T* get(int fd, uint32_t gen) const;
+    uint32_t generation(int fd) const;
+    // 只有代数匹配的调用者能够取走对象，保证同一个连接只会被释放一次
+    T* release(int fd, uint32_t gen);
+
+private:
+    struct Slot {
+        std::atomic<T*> obj{nullptr};
+        std::atomic<uint32_t> gen{0};
+    };
+    std::vector<Slot> m_slots;
+
+    bool inRange(int fd) const {return fd >= 0 && static_cast<size_t>(fd) < m_slots.size();}
+};
+
+
+template <typename T>
+uint32_t SlotTable<T>::insert(int fd, T* obj)
+{
+    assert(inRange(fd));
+    Slot& slot = m_slots[fd];
+    assert(slot.obj.load(std::memory_order_relaxed) == nullptr);
+    slot.obj.store(obj, std::memory_order_release);
+    return slot.gen.fetch_add(1, std::memory_order_acq_rel) + 1;
+}
+
+template <typename T>
+T* SlotTable<T>::get(int fd) const
+{
+    if (!inRange(fd)) return nullptr;
+    return m_slots[fd].obj.load(std::memory_order_acquire);
+}
+
+template <typename T>
+T* SlotTable<T>::get(int fd, uint32_t gen) const
+{
+    if (!inRange(fd)) return nullptr;
+    const Slot& slot = m_slots[fd];
+    T* obj = slot.obj.load(std::memory_order_acquire);
+    return slot.gen.load(std::memory_order_acquire) == gen ? obj : nullptr;
+}
+
+template <typename T>
+uint32_t SlotTable<T>::generation(int fd) const
+{
+    assert(inRange(fd));
+    return m_slots[fd].gen.load(std::memory_order_acquire);
+}
+
+template <typename T>
+T* SlotTable<T>::release(int fd, uint32_t gen)
+{
+    if (!inRange(fd)) return nullptr;
+    Slot& slot = m_slots[fd];
+    if (!slot.gen.compare_exchange_strong(gen, gen + 1, std::memory_order_acq_rel)) {
+        return nullptr;
+    }
+    return slot.obj.exchange(nullptr, std::memory_order_acq_rel);
+}
@@ -0,0 +1,458 @@
+#include "server/uringPoller.h"
+#include <string.h>
+#include <limits.h>
+#include <algorithm>
+#include "log/log.h"
+
+// POLL_REMOVE请求自身的完成事件，直接丢弃
+static const uint64_t REMOVE_TAG = UINT64_MAX;
+// 可以交给poll的事件，其余的标志位（EPOLLET、EPOLLONESHOT）由本类自己实现
+static const uint32_t POLL_MASK = EPOLLIN | EPOLLOUT | EPOLLPRI | EPOLLRDHUP;
+
+// user_data的高2位是请求类型，中间30位是fd，低32位是gen
+static inline uint64_t makeUserData(CompletionType type, int fd, uint32_t gen)
+{
+    return (static_cast<uint64_t>(type) << 62) | (static_cast<uint64_t>(fd & 0x3fffffff) << 32) | gen;
+}
+
+UringPoller::UringPoller(int maxEvent): m_ringFd(-1), m_sqRingPtr(MAP_FAILED),
+                                        m_sqes(static_cast<io_uring_sqe*>(MAP_FAILED)), m_cqRingPtr(MAP_FAILED),
+                                        m_bufRing(nullptr), m_bufMem(nullptr)
+{
+    assert(maxEvent > 0);
+    m_events.reserve(maxEvent);
+    unsigned entries = 1;
+    while (entries < static_cast<unsigned>(maxEvent)) entries <<= 1;
+    if (!setup(entries)) {
+        release();
+    }
+}
+
+UringPoller::~UringPoller()
+{
+    release();
+}
+
+bool UringPoller::setup(unsigned entries)
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    // 每个注册的fd都可能有一个完成事件，完成队列给大一些
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 4;
+
+    m_ringFd = syscall(__NR_io_uring_setup, entries, &params);
+    if (m_ringFd < 0) {
+        LOG_WARN("io_uring_setup error: %s", strerror(errno));
+        return false;
+    }
+    // 需要在等待时传入超时时间
+    if (!(params.features & IORING_FEAT_EXT_ARG)) {
+        LOG_WARN("io_uring does not support IORING_FEAT_EXT_ARG");
+        return false;
+    }
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+    }
+
+    m_sqRingPtr = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQ_RING);
+    if (m_sqRingPtr == MAP_FAILED) return false;
+    if (singleMmap) {
+        m_cqRingPtr = m_sqRingPtr;
+    } else {
+        m_cqRingPtr = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_CQ_RING);
+        if (m_cqRingPtr == MAP_FAILED) return false;
+    }
+
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    m_sqes = static_cast<io_uring_sqe*>(mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQES));
+    if (m_sqes == MAP_FAILED) return false;
+
+    char* sq = static_cast<char*>(m_sqRingPtr);
+    m_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    m_sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    m_sqEntries = params.sq_entries;
+
+    char* cq = static_cast<char*>(m_cqRingPtr);
+    m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    m_cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+}
+
+void UringPoller::release()
+{
+    // 关闭环的fd时内核自动注销缓冲区环
+    if (m_bufMem) munmap(m_bufMem, static_cast<size_t>(URING_RECV_BUFFER_NUM) * URING_RECV_BUFFER_SIZE);
+    if (m_bufRing) munmap(m_bufRing, URING_RECV_BUFFER_NUM * sizeof(io_uring_buf));
+    m_bufMem = nullptr;
+    m_bufRing = nullptr;
+    if (m_sqes != MAP_FAILED) munmap(m_sqes, m_sqesSize);
+    if (m_cqRingPtr != MAP_FAILED && m_cqRingPtr != m_sqRingPtr) munmap(m_cqRingPtr, m_cqRingSize);
+    if (m_sqRingPtr != MAP_FAILED) munmap(m_sqRingPtr, m_sqRingSize);
+    if (m_ringFd >= 0) close(m_ringFd);
+    m_sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    m_sqRingPtr = m_cqRingPtr = MAP_FAILED;
+    m_ringFd = -1;
+}
+
+bool UringPoller::addFd(int fd, uint32_t events)
+{
+    if (fd < 0) return false;
+    std::lock_guard<std::mutex> lock(m_mtx);
+    FdState& st = state(fd);
+    if (st.registered) return false;
+    st.registered = true;
+    st.events = events;
+    ++ st.gen;
+    bool res = armPoll(fd, st);
+    return flushIfForeign() && res;
+}
+
+bool UringPoller::modFd(int fd, uint32_t events)
+{
+    if (fd < 0) return false;
+    std::lock_guard<std::mutex> lock(m_mtx);
+    FdState& st = state(fd);
+    if (!st.registered) return false;
+    removePoll(fd, st);
+    st.events = events;
+    bool res = armPoll(fd, st);
+    return flushIfForeign() && res;
+}
+
+bool UringPoller::delFd(int fd)
+{
+    if (fd < 0) return false;
+    std::lock_guard<std::mutex> lock(m_mtx);
+    FdState& st = state(fd);
+    if (!st.registered) return false;
+    // poll请求持有文件的引用，必须显式取消，不能依赖close
+    removePoll(fd, st);
+    st.registered = false;
+    return flushIfForeign();
+}
+
+int UringPoller::wait(int timeoutMs)
+{
+    unsigned toSubmit;
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_loopThread = std::this_thread::get_id();
+        // 上一次交给调用者的接收缓冲区已经用完
+        recycleBuffers();
+        toSubmit = pending();
+    }
+
+    // 提交积累的请求并等待完成事件，只需要一次系统调用
+    int ret = submit(timeoutMs == 0 ? 0 : 1, timeoutMs, toSubmit);
+    if (ret < 0 && errno != ETIME && errno != EBUSY) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_events.clear();
+    unsigned head = *m_cqHead;
+    unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+    while (head != tail && m_events.size() < m_events.capacity()) {
+        io_uring_cqe* cqe = &m_cqes[head & *m_cqMask];
+        ++ head;
+        if (cqe->user_data == REMOVE_TAG) continue;
+
+        CompletionType type = static_cast<CompletionType>(cqe->user_data >> 62);
+        int fd = static_cast<int>((cqe->user_data >> 32) & 0x3fffffff);
+        uint32_t gen = static_cast<uint32_t>(cqe->user_data);
+        bool more = cqe->flags & IORING_CQE_F_MORE;
+
+        // 完成事件是否过期由调用者根据gen判断，接收缓冲区无论如何都要回收
+        if (type != COMPLETION_POLL) {
+            Completion c = {type, fd, gen, cqe->res, nullptr, more};
+            if (cqe->flags & IORING_CQE_F_BUFFER) {
+                uint16_t bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+                c.data = m_bufMem + static_cast<size_t>(bid) * URING_RECV_BUFFER_SIZE;
+                m_recycle.push_back(bid);
+            }
+            m_events.push_back(c);
+            continue;
+        }
+
+        if (static_cast<size_t>(fd) >= m_fds.size()) continue;
+        FdState& st = m_fds[fd];
+        // fd已经被删除或重新注册，属于过期的完成事件
+        if (!st.registered || st.gen != gen) continue;
+
+        if (!more) st.armed = false;
+        if (cqe->res == -ECANCELED) continue;
+
+        uint32_t events = cqe->res >= 0 ? static_cast<uint32_t>(cqe->res) : static_cast<uint32_t>(EPOLLERR);
+        m_events.push_back({COMPLETION_POLL, fd, gen, static_cast<int>(events), nullptr, more});
+        // multishot poll可能被内核终止，需要重新注册
+        if (!more && !(st.events & EPOLLONESHOT)) {
+            armPoll(fd, st);
+        }
+    }
+    __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+    return static_cast<int>(m_events.size());
+}
+
+int UringPoller::getEventFd(size_t i) const
+{
+    assert(i < m_events.size());
+    return m_events[i].fd;
+}
+
+uint32_t UringPoller::getEvents(size_t i) const
+{
+    assert(i < m_events.size());
+    return static_cast<uint32_t>(m_events[i].res);
+}
+
+const Completion* UringPoller::getCompletion(size_t i) const
+{
+    assert(i < m_events.size());
+    return m_events[i].type == COMPLETION_POLL ? nullptr : &m_events[i];
+}
+
+bool UringPoller::enableCompletion()
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (m_bufRing) return true;
+    if (!valid()) return false;
+
+    // 缓冲区环需要页对齐
+    void* ring = mmap(nullptr, URING_RECV_BUFFER_NUM * sizeof(io_uring_buf), PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) return false;
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+    reg.ring_entries = URING_RECV_BUFFER_NUM;
+    reg.bgid = 0;
+    if (syscall(__NR_io_uring_register, m_ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        LOG_WARN("io_uring does not support provided buffer rings: %s", strerror(errno));
+        munmap(ring, URING_RECV_BUFFER_NUM * sizeof(io_uring_buf));
+        return false;
+    }
+    m_bufRing = static_cast<io_uring_buf_ring*>(ring);
+
+    void* mem = mmap(nullptr, static_cast<size_t>(URING_RECV_BUFFER_NUM) * URING_RECV_BUFFER_SIZE,
+                     PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return false;
+    m_bufMem = static_cast<char*>(mem);
+
+    // 所有缓冲区都交给内核
+    for (uint16_t i = 0; i < URING_RECV_BUFFER_NUM; ++ i) {
+        m_recycle.push_back(i);
+    }
+    recycleBuffers();
+    return true;
+}
+
+bool UringPoller::acceptMulti(int listenFd)
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    io_uring_sqe* sqe = getSqe();
+    if (sqe == nullptr) return false;
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listenFd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK;
+    sqe->user_data = makeUserData(COMPLETION_ACCEPT, listenFd, 0);
+    pushSqe();
+    return true;
+}
+
+bool UringPoller::recvMulti(int fd, uint32_t gen)
+{
+    assert(m_bufRing != nullptr);
+    std::lock_guard<std::mutex> lock(m_mtx);
+    io_uring_sqe* sqe = getSqe();
+    if (sqe == nullptr) return false;
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = 0;
+    sqe->user_data = makeUserData(COMPLETION_RECV, fd, gen);
+    pushSqe();
+    return true;
+}
+
+int UringPoller::sendMsg(int fd, uint32_t gen, const iovec* iov, size_t count)
+{
+    assert(count > 0);
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (static_cast<size_t>(fd) >= m_sends.size()) {
+        m_sends.resize(std::max(static_cast<size_t>(fd) + 1, m_sends.size() * 2));
+    }
+    SendState& st = m_sends[fd];
+    st.iov.assign(iov, iov + count);
+    size_t num = (count + IOV_MAX - 1) / IOV_MAX;
+    st.msgs.assign(num, msghdr());
+
+    // 链接的请求必须在同一次提交中
+    if (m_sqEntries - pending() < num) {
+        submit(0, 0, pending());
+        if (m_sqEntries - pending() < num) {
+            LOG_ERROR("io_uring submission queue is full");
+            return 0;
+        }
+    }
+    for (size_t i = 0; i < num; ++ i) {
+        msghdr& msg = st.msgs[i];
+        msg.msg_iov = &st.iov[i * IOV_MAX];
+        msg.msg_iovlen = std::min<size_t>(IOV_MAX, count - i * IOV_MAX);
+
+        io_uring_sqe* sqe = getSqe();
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(&msg);
+        sqe->len = 1;
+        // 非阻塞的套接字也由内核一直发送到全部完成或者出错
+        sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+        if (i + 1 < num) {
+            sqe->flags = IOSQE_IO_LINK;
+        }
+        sqe->user_data = makeUserData(COMPLETION_SEND, fd, gen);
+        pushSqe();
+    }
+    return static_cast<int>(num);
+}
+
+void UringPoller::cancel(int fd, uint32_t gen)
+{
+    std::lock_guard<std::mutex> lock(m_mtx);
+    for (CompletionType type : {COMPLETION_RECV, COMPLETION_SEND}) {
+        io_uring_sqe* sqe = getSqe();
+        if (sqe == nullptr) return;
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = makeUserData(type, fd, gen);
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_ALL;
+        sqe->user_data = REMOVE_TAG;
+        pushSqe();
+    }
+}
+
+UringPoller::FdState& UringPoller::state(int fd)
+{
+    if (static_cast<size_t>(fd) >= m_fds.size()) {
+        m_fds.resize(std::max(static_cast<size_t>(fd) + 1, m_fds.size() * 2));
+    }
+    return m_fds[fd];
+}
+
+io_uring_sqe* UringPoller::getSqe()
+{
+    unsigned tail = *m_sqTail;
+    if (tail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries) {
+        // 提交队列已满，先把积累的请求交给内核
+        submit(0, 0, pending());
+        if (tail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries) {
+            LOG_ERROR("io_uring submission queue is full");
+            return nullptr;
+        }
+    }
+    io_uring_sqe* sqe = &m_sqes[tail & *m_sqMask];
+    memset(sqe, 0, sizeof(*sqe));
+    m_sqArray[tail & *m_sqMask] = tail & *m_sqMask;
+    return sqe;
+}
+
+void UringPoller::pushSqe()
+{
+    // 请求填写完整之后才对内核可见
+    __atomic_store_n(m_sqTail, *m_sqTail + 1, __ATOMIC_RELEASE);
+}
+
+void UringPoller::recycleBuffers()
+{
+    if (m_recycle.empty()) return;
+    const unsigned mask = URING_RECV_BUFFER_NUM - 1;
+    // C++中__DECLARE_FLEX_ARRAY的空结构体占一个字节，bufs的偏移不是0，直接从环的起始地址取
+    io_uring_buf* bufs = reinterpret_cast<io_uring_buf*>(m_bufRing);
+    uint16_t tail = m_bufRing->tail;
+    for (uint16_t bid : m_recycle) {
+        io_uring_buf* buf = &bufs[tail & mask];
+        buf->addr = reinterpret_cast<uint64_t>(m_bufMem + static_cast<size_t>(bid) * URING_RECV_BUFFER_SIZE);
+        buf->len = URING_RECV_BUFFER_SIZE;
+        buf->bid = bid;
+        ++ tail;
+    }
+    __atomic_store_n(&m_bufRing->tail, tail, __ATOMIC_RELEASE);
+    m_recycle.clear();
+}
+
+bool UringPoller::armPoll(int fd, FdState& st)
+{
+    io_uring_sqe* sqe = getSqe();
+    if (sqe == nullptr) return false;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = st.events & POLL_MASK;
+    if (!(st.events & EPOLLONESHOT)) {
+        sqe->len = IORING_POLL_ADD_MULTI;
+    }
+    sqe->user_data = makeUserData(COMPLETION_POLL, fd, st.gen);
+    pushSqe();
+    st.armed = true;
+    return true;
+}
+
+bool UringPoller::removePoll(int fd, FdState& st)
+{
+    uint64_t oldData = makeUserData(COMPLETION_POLL, fd, st.gen);
+    // 之后到达的旧完成事件会因为gen不同被丢弃
+    ++ st.gen;
+    if (!st.armed) return true;
+    st.armed = false;
+
+    io_uring_sqe* sqe = getSqe();
+    if (sqe == nullptr) return false;
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = oldData;
+    sqe->user_data = REMOVE_TAG;
+    pushSqe();
+    return true;
+}
+
+int UringPoller::submit(unsigned waitNr, int timeoutMs, unsigned toSubmit)
+{
+    unsigned flags = 0;
+    io_uring_getevents_arg arg;
+    __kernel_timespec ts;
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    if (waitNr > 0) {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        if (timeoutMs >= 0) {
+            ts.tv_sec = timeoutMs / 1000;
+            ts.tv_nsec = (timeoutMs % 1000) * 1000000LL;
+            arg.ts = reinterpret_cast<uint64_t>(&ts);
+        }
+    }
+    if (toSubmit == 0 && waitNr == 0) return 0;
+    return syscall(__NR_io_uring_enter, m_ringFd, toSubmit, waitNr, flags,
+                   (flags & IORING_ENTER_EXT_ARG) ? &arg : nullptr, sizeof(arg));
+}
+
+bool UringPoller::flushIfForeign()
+{
+    // 事件循环线程中的修改留到下一次wait一起提交
+    if (std::this_thread::get_id() == m_loopThread) return true;
+    return submit(0, 0, pending()) >= 0;
+}
+
+unsigned UringPoller::pending() const
+{
+    // 没有使用SQPOLL，内核只在io_uring_enter中消费提交队列，多报的数量会被内核忽略
+    return *m_sqTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+}
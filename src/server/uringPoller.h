@@ -0,0 +1,138 @@
+#pragma once
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "poller.h"
+
+// 完成模式下每个事件循环的接收缓冲区，内核收到数据时从中选择一块
+#define URING_RECV_BUFFER_SIZE 16384
+#define URING_RECV_BUFFER_NUM 128
+
+// 完成事件的类型，POLL是就绪通知
+enum CompletionType {
+    COMPLETION_POLL,
+    COMPLETION_ACCEPT,
+    COMPLETION_RECV,
+    COMPLETION_SEND,
+};
+
+/*
+完成模式中一个请求的结果，res小于0时是错误码
+ACCEPT：res是新连接的fd
+RECV：res是收到的字节数，0表示对端关闭，data指向内核选择的接收缓冲区，下一次wait时归还给内核
+SEND：res是这一个sendmsg发送的字节数
+more为false时accept和recv请求已经结束，需要重新提交
+*/
+struct Completion {
+    CompletionType type;
+    int fd;
+    uint32_t gen;
+    int res;
+    const char* data;
+    bool more;
+};
+
+/*
+基于io_uring的多路复用后端，有两种用法：
+就绪模式：通过IORING_OP_POLL_ADD实现与epoll相同的就绪通知语义，读写仍然由调用者完成
+    带EPOLLONESHOT的fd使用单次poll，触发后需要modFd重新注册；其它fd使用multishot poll
+    在事件循环线程中调用的addFd/modFd/delFd只写入提交队列，在下一次wait时和等待一起提交，
+    一次系统调用完成所有的注册和等待；其它线程（线程池）调用时立即提交
+完成模式：enableCompletion之后可以直接提交accept、recv和sendmsg，wait返回的是操作的结果
+    multishot accept，multishot recv从注册的缓冲区环中选择缓冲区，连接多时不需要每个连接一个接收缓冲区
+    超过IOV_MAX个切片的发送拆成多个链接在一起的sendmsg，由内核按顺序执行
+    完成模式的调用都只能在事件循环线程中进行，请求和下一次等待一起提交
+*/
+class UringPoller : public Poller {
+public:
+    explicit UringPoller(int maxEvent = 1024);
+    ~UringPoller();
+
+    bool valid() const {return m_ringFd >= 0;}
+
+    bool addFd(int fd, uint32_t events) override;
+    bool modFd(int fd, uint32_t events) override;
+    bool delFd(int fd) override;
+    int wait(int timeoutMs = -1) override;
+    int getEventFd(size_t i) const override;
+    uint32_t getEvents(size_t i) const override;
+
+    // 注册接收缓冲区环，内核不支持时返回false，只能使用就绪模式
+    bool enableCompletion();
+    // gen由调用者分配，原样出现在完成事件中，用于识别fd被复用之前的旧请求
+    bool acceptMulti(int listenFd);
+    bool recvMulti(int fd, uint32_t gen);
+    // 发送iov中的全部数据，iov数组由poller保存，数据本身在所有完成事件到达之前必须有效
+    // 返回提交的sendmsg个数，每个都有一个完成事件，提交失败时返回0
+    int sendMsg(int fd, uint32_t gen, const iovec* iov, size_t count);
+    // 取消fd上的接收和发送，被取消的请求以-ECANCELED完成
+    void cancel(int fd, uint32_t gen);
+    // 第i个事件是完成事件时返回它，就绪事件返回nullptr
+    const Completion* getCompletion(size_t i) const;
+
+private:
+    // 每个fd当前注册的事件，gen用于丢弃fd被删除或复用之后才到达的旧完成事件
+    struct FdState {
+        uint32_t gen = 0;
+        uint32_t events = 0;
+        bool armed = false;
+        bool registered = false;
+    };
+
+    // 一次发送使用的iovec和msghdr，在完成事件到达之前不能修改
+    struct SendState {
+        std::vector<iovec> iov;
+        std::vector<msghdr> msgs;
+    };
+
+    int m_ringFd;
+    // 提交队列
+    void* m_sqRingPtr;
+    size_t m_sqRingSize;
+    unsigned* m_sqHead;
+    unsigned* m_sqTail;
+    unsigned* m_sqMask;
+    unsigned* m_sqArray;
+    unsigned m_sqEntries;
+    io_uring_sqe* m_sqes;
+    size_t m_sqesSize;
+    // 完成队列
+    void* m_cqRingPtr;
+    size_t m_cqRingSize;
+    unsigned* m_cqHead;
+    unsigned* m_cqTail;
+    unsigned* m_cqMask;
+    io_uring_cqe* m_cqes;
+
+    // 接收缓冲区环和缓冲区，上一次wait交出去的缓冲区在下一次wait开始时归还
+    io_uring_buf_ring* m_bufRing;
+    char* m_bufMem;
+    std::vector<uint16_t> m_recycle;
+
+    std::mutex m_mtx;
+    std::thread::id m_loopThread;
+    std::vector<FdState> m_fds;
+    std::vector<SendState> m_sends;
+    std::vector<Completion> m_events;
+
+    bool setup(unsigned entries);
+    void release();
+    FdState& state(int fd);
+    io_uring_sqe* getSqe();
+    void pushSqe();
+    bool armPoll(int fd, FdState& st);
+    bool removePoll(int fd, FdState& st);
+    void recycleBuffers();
+    unsigned pending() const;
+    int submit(unsigned waitNr, int timeoutMs, unsigned toSubmit);
+    bool flushIfForeign();
+};
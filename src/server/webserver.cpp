@@ -2,156 +2,213 @@
 
 std::atomic<bool> Webserver::m_stop = false;
 
-Webserver::Webserver(int threadNum, int connectNum, size_t objectNum, 
+Webserver::Webserver(int threadNum, int connectNum, size_t objectNum,
                     int port, int sqlPort, int redisPort, const char* host,
                     const char *dbName, const char *sqlUser, const char *sqlPwd,
-                    int timeoutMS, int MAX_FD, size_t userCount):
-                    m_threadPool(new ThreadPool(threadNum)), m_sqlConnectPool(new MySQLConnectionPool(host, sqlUser, sqlPwd, dbName, sqlPort)),
-                    m_redisConnectPool(new RedisConnectionPool(host, redisPort)), m_epoller(new Epoller), m_port(port),
-                    m_timer(new HeapTimer), m_timeoutMS(timeoutMS), MAX_FD(MAX_FD), m_userCount(userCount)
+                    int timeoutMS, int MAX_FD, int loopNum, DispatchMode dispatchMode,
+                    bool reusePort, int backlog, PollerType pollerType, bool sendFile,
+                    size_t cacheFileSize, size_t cacheMemory, const char* cpuAffinity, SCHED_MODE schedMode):
+                    m_threadPool(nullptr), m_sqlConnectPool(new MySQLConnectionPool(host, sqlUser, sqlPwd, dbName, sqlPort)),
+                    m_redisConnectPool(new RedisConnectionPool(host, redisPort)), m_mainLoop(nullptr),
+                    m_dispatchMode(dispatchMode), m_pollerType(pollerType), m_schedMode(schedMode), m_nextLoop(0),
+                    m_port(port), m_reusePort(reusePort), m_backlog(backlog),
+                    m_timeoutMS(timeoutMS), MAX_FD(MAX_FD)
 {
     LOG_INFO("========== Server init ==========");
     initEventMode();
 
     m_srcDir = "/project/webserver/resources";
     HttpConnect::m_srcDir = m_srcDir;
+    HttpConnect::m_sendFile = sendFile;
+    ResponseCache::getInstance()->setLimits(cacheFileSize, cacheMemory);
 
-    m_objectPool = new ObjectPool<HttpConnect>(objectNum, m_sqlConnectPool, m_redisConnectPool);
+    if (!affinity::parse(cpuAffinity, m_affinity)) {
+        LOG_ERROR("Invalid cpu affinity: %s", cpuAffinity);
+    }
+    if (m_affinity.log >= 0) {
+        Log::getInstance()->setCpu(m_affinity.log);
+    }
+    initLoops(loopNum, threadNum, objectNum);
+    if (sendFile && m_mainLoop->completionMode()) {
+        LOG_WARN("io_uring completion mode sends files from memory, sendfile is disabled");
+        HttpConnect::m_sendFile = false;
+    }
     if (!initSocket()) {
         m_stop = true;
         LOG_ERROR("Socket init error!");
     }
+    for (auto loop : m_subLoops) {
+        loop->start();
+    }
 }
 
 Webserver::~Webserver()
 {
-    close(m_listenFd);
     m_stop = true;
-    m_threadPool->shutdown();
+    // 先停止从reactor，避免其继续使用线程池和对象池
+    for (auto loop : m_subLoops) {
+        delete loop;
+    }
+    if (m_threadPool) {
+        m_threadPool->shutdown();
+    }
+    for (int fd : m_listenFds) {
+        close(fd);
+    }
 
     // 释放资源
+    delete m_mainLoop;
     delete m_threadPool;
     delete m_sqlConnectPool;
     delete m_redisConnectPool;
     delete m_objectPool;
-    delete m_epoller;
-    delete m_timer;
 }
 
 void Webserver::eventLoop()
 {
-    int timeMS = -1;
     if(!m_stop) { LOG_INFO("========== Server start =========="); }
     while (!m_stop) {
-        timeMS = m_timer->GetNextTick();    // 默认返回的是-1
-        int eventCount = m_epoller->wait();
-        for (int i = 0; i < eventCount; ++ i) {
-            int fd = m_epoller->getEventFd(i);
-            uint32_t events = m_epoller->getEvents(i);
-            if (fd == m_listenFd) {
-                dealListen();
-            } else if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
-                assert(mp_users.count(fd));
-                closeConn(std::string("Epoll cause close."), mp_users[fd]);
-            } else if (events & EPOLLIN) {
-                assert(mp_users.count(fd) > 0);
-                dealRead(mp_users[fd]);
-            } else if (events & EPOLLOUT) {
-                assert(mp_users.count(fd) > 0);
-                dealWrite(mp_users[fd]);
-            } else {
-                LOG_ERROR("Unexpected event on fd[%d]: events = 0x%x", fd, events);
-            }
-        }
+        m_mainLoop->loopOnce();
     }
 }
 
-void Webserver::dealListen()
+void Webserver::initLoops(int loopNum, int threadNum, size_t objectNum)
 {
-    struct sockaddr_in addr;
-    socklen_t len = sizeof(addr);
-    while (true) {
-        int fd = accept(m_listenFd, (struct sockaddr*)&addr, &len);
-        if (fd <= 0) return;
-        else if (m_userCount >= MAX_FD) {
-            sendError(fd, "Server busy!");
-            LOG_WARN("Client is full");
-            close(fd);
-            return;
+    // 单reactor模式下主循环自己管理连接，读写交给线程池
+    if (loopNum <= 0) {
+        m_threadPool = new ThreadPool(threadNum, MIN_THREADS, MAX_THREADS,
+                                      std::chrono::milliseconds(DEFAULT_INTERVAL), m_schedMode);
+        m_threadPool->setCpus(m_affinity.workers);
+        m_threadPool->init();
+        // 主线程就是事件循环，工作线程和线程池的控制器都创建之后再绑核，它们不会继承主线程的CPU集合
+        // 绑核之后再分配对象池
+        if (!m_affinity.loops.empty()) {
+            affinity::pinThread(m_affinity.loops[0]);
         }
-        else {
-            addClient(fd, addr);
+        m_objectPool = new ObjectPool<HttpConnect>(objectNum, MAX_FD, m_sqlConnectPool, m_redisConnectPool);
+        m_mainLoop = new EventLoop(m_objectPool, m_threadPool, m_timeoutMS, m_connEvent, MAX_FD, m_pollerType);
+        return;
+    }
+
+    // 主从reactor模式下主循环只负责accept
+    m_objectPool = new ObjectPool<HttpConnect>(objectNum, MAX_FD, m_sqlConnectPool, m_redisConnectPool);
+    m_mainLoop = new EventLoop(m_objectPool, nullptr, m_timeoutMS, m_connEvent, MAX_FD, m_pollerType);
+    for (int i = 0; i < loopNum; ++ i) {
+        EventLoop* loop = new EventLoop(m_objectPool, nullptr, m_timeoutMS, m_connEvent, MAX_FD, m_pollerType);
+        if (!m_affinity.loops.empty()) {
+            MySQLConnectionPool* sql = m_sqlConnectPool;
+            RedisConnectionPool* redis = m_redisConnectPool;
+            size_t maxFd = MAX_FD;
+            loop->setCpu(m_affinity.loops[i % m_affinity.loops.size()], [objectNum, maxFd, sql, redis]() {
+                return new ObjectPool<HttpConnect>(objectNum, maxFd, sql, redis);
+            });
         }
+        m_subLoops.push_back(loop);
     }
+    LOG_INFO("Sub reactor nums: %d, dispatch mode: %s", loopNum,
+             m_dispatchMode == LEAST_LOADED ? "least loaded" : "round robin");
 }
 
-void Webserver::closeConn(const std::string& message, HttpConnect *client)
+// owner不为空时在owner所在的线程中accept，连接直接加入owner
+void Webserver::dealListen(int listenFd, EventLoop* owner)
 {
-    // 这行代码的原因是在时间堆回调的时候，这个对象已经被回收到池中了，从哈希表中已经移除，因此是无法找到的    
-    if (client == nullptr) return;
-    // 调试使用
-    LOG_INFO("Client[%d] quit, the quit reason is: %s", client->getFd(), message.c_str());
-    m_epoller->delFd(client->getFd());
-    client->closeClient();
-    client->m_isClosed = true;
-    mp_users.erase(client->getFd());
-    client->clearResource();
-    m_objectPool->releaseObject(client);
-    -- m_userCount;
+    struct sockaddr_in addr;
+    while (true) {
+        // accept会改写len，每次都要重新设置
+        socklen_t len = sizeof(addr);
+        int fd = accept(listenFd, (struct sockaddr*)&addr, &len);
+        if (fd <= 0 || !dispatch(fd, addr, owner)) return;
+    }
 }
 
-void Webserver::dealRead(HttpConnect *client)
+void Webserver::onAccept(int fd, EventLoop* owner)
 {
-    assert(client);
-    extentTime(client);
-    auto task = std::bind(&Webserver::onRead, this, client);
-    m_threadPool->submit(task);
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    if (getpeername(fd, (struct sockaddr*)&addr, &len) < 0) {
+        close(fd);
+        return;
+    }
+    dispatch(fd, addr, owner);
 }
 
-void Webserver::dealWrite(HttpConnect *client)
+bool Webserver::dispatch(int fd, const sockaddr_in& addr, EventLoop* owner)
 {
-    assert(client);
-    extentTime(client);
-    auto task = std::bind(&Webserver::onWrite, this, client);
-    m_threadPool->submit(task);
+    if (userCount() >= static_cast<size_t>(MAX_FD)) {
+        EventLoop::sendError(fd, "Server busy!");
+        LOG_WARN("Client is full");
+        return false;
+    }
+    else if (owner) {
+        owner->addClient(fd, addr);
+    }
+    else if (m_subLoops.empty()) {
+        m_mainLoop->addClient(fd, addr);
+    }
+    else {
+        nextLoop()->queueClient(fd, addr);
+    }
+    return true;
 }
 
-void Webserver::onProcess(HttpConnect *client)
+size_t Webserver::userCount() const
 {
-    if (client->process()) {
-        m_epoller->modFd(client->getFd(), m_connEvent | EPOLLOUT);
-    } else {
-        m_epoller->modFd(client->getFd(), m_connEvent | EPOLLIN);       
+    size_t count = m_mainLoop->userCount();
+    for (auto loop : m_subLoops) {
+        count += loop->userCount();
     }
+    return count;
 }
 
-void Webserver::addClient(int fd, sockaddr_in addr)
+EventLoop* Webserver::nextLoop()
 {
-    assert(fd > 0);
-    auto obj = m_objectPool->acquireObject();
-    obj->init(fd, addr);
-    if (m_timeoutMS > 0) {
-        m_timer->add(fd, m_timeoutMS, std::bind(&Webserver::closeConn, this, std::string("Timer cause client close"), mp_users[fd]));
+    assert(!m_subLoops.empty());
+    if (m_dispatchMode == LEAST_LOADED) {
+        EventLoop* res = m_subLoops[0];
+        for (auto loop : m_subLoops) {
+            if (loop->userCount() < res->userCount()) {
+                res = loop;
+            }
+        }
+        return res;
     }
-    // 设置读事件到来的epoll触发
-    m_epoller->addFd(fd, EPOLLIN | m_connEvent);
-    setFdNonBlock(fd);
-    mp_users[fd] = obj;
-    ++ m_userCount;
-    LOG_INFO("Client[%d] in!", fd);
+    EventLoop* res = m_subLoops[m_nextLoop];
+    m_nextLoop = (m_nextLoop + 1) % m_subLoops.size();
+    return res;
 }
 
-void Webserver::sendError(int fd, const char *info)
+bool Webserver::initSocket()
 {
-    assert(fd > 0);
-    int ret = send(fd, info, strlen(info), 0);
-    if (ret < 0) {
-        LOG_WARN("Send error to client[%d] error!", fd);
+    // 每个从reactor拥有自己的监听套接字
+    if (m_reusePort && !m_subLoops.empty()) {
+        for (auto loop : m_subLoops) {
+            int fd = createListenFd();
+            if (fd < 0) return false;
+            m_listenFds.push_back(fd);
+            if (!loop->setListen(fd, m_listenEvent, std::bind(&Webserver::dealListen, this, fd, loop),
+                                 std::bind(&Webserver::onAccept, this, std::placeholders::_1, loop))) {
+                LOG_ERROR("Add listen error!");
+                return false;
+            }
+        }
+        LOG_INFO("Server port:%d, reuseport listeners: %zu", m_port, m_listenFds.size());
+        return true;
     }
-    close(fd);
+
+    int fd = createListenFd();
+    if (fd < 0) return false;
+    m_listenFds.push_back(fd);
+    // 可读事件，当有新的客户端连接时触发
+    if (!m_mainLoop->setListen(fd, m_listenEvent, std::bind(&Webserver::dealListen, this, fd, nullptr),
+                               std::bind(&Webserver::onAccept, this, std::placeholders::_1, nullptr))) {
+        LOG_ERROR("Add listen error!");
+        return false;
+    }
+    LOG_INFO("Server port:%d", m_port);
+    return true;
 }
 
-bool Webserver::initSocket()
+int Webserver::createListenFd()
 {
     int ret;
     struct sockaddr_in addr;
@@ -159,100 +216,53 @@ bool Webserver::initSocket()
     addr.sin_addr.s_addr = htonl(INADDR_ANY);
     addr.sin_port = htons(m_port);
 
-    m_listenFd = socket(AF_INET, SOCK_STREAM, 0);
-    if (m_listenFd < 0) {
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) {
         LOG_ERROR("Create socket error");
-        return false;
+        return -1;
     }
 
     int optval = 1;
-    ret = setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, (const void*)&optval, sizeof(int));
+    ret = setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, (const void*)&optval, sizeof(int));
     if (ret == -1) {
         LOG_ERROR("set socket setsockopt error !");
-        close(m_listenFd);
-        return false;
+        close(listenFd);
+        return -1;
     }
 
-    ret = bind(m_listenFd, (struct sockaddr*)&addr, sizeof(addr));
-    if (ret < 0) {
-        LOG_ERROR("Bind Port:%d error!");
-        close(m_listenFd);
-        return false;
+    // 多个套接字绑定同一个端口，由内核把连接分散到各个套接字上
+    if (m_reusePort) {
+        ret = setsockopt(listenFd, SOL_SOCKET, SO_REUSEPORT, (const void*)&optval, sizeof(int));
+        if (ret == -1) {
+            LOG_ERROR("set socket SO_REUSEPORT error !");
+            close(listenFd);
+            return -1;
+        }
     }
 
-    ret = listen(m_listenFd, 8);
-    if(ret < 0) {
-        LOG_ERROR("Listen port:%d error!");
-        close(m_listenFd);
-        return false;
+    ret = bind(listenFd, (struct sockaddr*)&addr, sizeof(addr));
+    if (ret < 0) {
+        LOG_ERROR("Bind Port:%d error!", m_port);
+        close(listenFd);
+        return -1;
     }
 
-    // 可读事件，当有新的客户端连接时触发
-    ret = m_epoller->addFd(m_listenFd,  m_listenEvent | EPOLLIN);
-    if(ret == 0) {
-        LOG_ERROR("Add listen error!");
-        close(m_listenFd);
-        return false;
+    ret = listen(listenFd, m_backlog);
+    if(ret < 0) {
+        LOG_ERROR("Listen port:%d error!", m_port);
+        close(listenFd);
+        return -1;
     }
 
-    setFdNonBlock(m_listenFd); 
-    LOG_INFO("Server port:%d", m_port);
-    return true;
-}
-
-int Webserver::setFdNonBlock(int fd)
-{
-    assert(fd > 0);
-    return fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    EventLoop::setFdNonBlock(listenFd);
+    return listenFd;
 }
 
 void Webserver::initEventMode()
 {
     m_listenEvent = EPOLLRDHUP;
-    m_connEvent = EPOLLONESHOT | EPOLLRDHUP; 
+    m_connEvent = EPOLLONESHOT | EPOLLRDHUP;
 
     m_connEvent |= EPOLLET;
     m_listenEvent |= EPOLLET;
 }
-
-void Webserver::extentTime(HttpConnect *client)
-{
-    assert(client);
-    if (m_timeoutMS > 0) {
-        m_timer->adjust(client->getFd(), m_timeoutMS);
-    }
-}
-
-void Webserver::onRead(HttpConnect *client)
-{
-    assert(client);
-    int ret = -1;
-    int readErrno = 0;
-    ret = client->read(&readErrno);
-    if (ret <= 0 && readErrno != EAGAIN) {
-        closeConn(std::string("Read Error cause client close."), client);
-        return;
-    }
-    onProcess(client);
-}
-
-void Webserver::onWrite(HttpConnect *client)
-{
-    assert(client);
-    int ret = -1;
-    int writeErrno = 0;
-    ret = client->write(&writeErrno);
-    if (client->toWriteBytes() == 0) {
-        if (client->isKeepAlive()) {
-            m_epoller->modFd(client->getFd(), m_connEvent | EPOLLIN);
-            return;
-        }
-    } else if (ret < 0) {
-        // 继续传输
-        if (writeErrno == EAGAIN) {
-            m_epoller->modFd(client->getFd(), m_connEvent | EPOLLOUT);
-            return;
-        }
-    }
-    closeConn(std::string("Write error cause client close"), client);
-}
\ No newline at end of file
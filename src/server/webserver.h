@@ -4,22 +4,43 @@
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <string.h>
-#include <unordered_map>
+#include <vector>
 #include <iostream>
 
 #include "pool/objectPool.h"
 #include "pool/threadPool.h"
 #include "http/httpConnect.h"
-#include "timer/heapTimer.h"
 #include "log/log.h"
-#include "epoller.h"
+#include "eventLoop.h"
 
+// 主reactor把新连接分发给从reactor的方式
+enum DispatchMode {
+    ROUND_ROBIN,
+    LEAST_LOADED,
+};
+
+/*
+loopNum为0时是单reactor模式：主线程的事件循环负责所有连接，读写交给线程池
+loopNum大于0时是主从reactor模式：主线程只负责accept，连接交给loopNum个从reactor线程处理
+reusePort为true时每个从reactor都用SO_REUSEPORT打开自己的监听套接字，直接accept到自己的循环中，由内核均衡连接
+pollerType选择每个事件循环使用的IO多路复用后端（epoll或io_uring）
+    主从reactor模式下使用io_uring时连接的收发也交给io_uring完成，io_uring没有sendfile，sendFile不起作用
+sendFile为true时静态文件使用sendfile零拷贝发送，不再mmap到进程中
+不超过cacheFileSize的文件缓存完整响应，缓存总大小不超过cacheMemory，cacheFileSize为0时关闭
+cpuAffinity配置事件循环、工作线程和日志线程绑定的CPU，格式见util/affinity.h，为空时不绑定
+绑定之后每个从reactor使用自己的连接对象池，连接从加入到关闭都在同一个CPU和NUMA节点上
+schedMode是单reactor模式下线程池的调度方式
+objectNum是预先创建的连接对象数，之后按需创建，每个对象池最多MAX_FD个
+*/
 class Webserver {
 public:
-    Webserver(int threadNum = 10, int connectNum = 10, size_t objectNum = 10, 
+    Webserver(int threadNum = 10, int connectNum = 10, size_t objectNum = 10,
               int port = 1317, int sqlPort = 3306, int redisPort = 6379, const char* host = "192.168.19.133",
               const char* dbName = "webserverDB", const char* sqlUser = "root", const char* sqlPwd = "123456",
-              int timeoutMS = 60000, int MAX_FD = 65535, size_t userCount = 0);
+              int timeoutMS = 60000, int MAX_FD = 65535, int loopNum = 0, DispatchMode dispatchMode = ROUND_ROBIN,
+              bool reusePort = false, int backlog = 1024, PollerType pollerType = EPOLL, bool sendFile = false,
+              size_t cacheFileSize = RESPONSE_CACHE_FILE_SIZE, size_t cacheMemory = RESPONSE_CACHE_MEMORY,
+              const char* cpuAffinity = nullptr, SCHED_MODE schedMode = SHARED_QUEUE);
     ~Webserver();
     void eventLoop();
     static void setCloseServer(int) {m_stop = true;}
@@ -30,34 +51,36 @@ private:
     RedisConnectionPool* m_redisConnectPool;
     ObjectPool<HttpConnect>* m_objectPool;
 
-    HeapTimer* m_timer;
-    Epoller* m_epoller;
+    EventLoop* m_mainLoop;
+    std::vector<EventLoop*> m_subLoops;
+    DispatchMode m_dispatchMode;
+    PollerType m_pollerType;
+    SCHED_MODE m_schedMode;
+    size_t m_nextLoop;
+    affinity::Config m_affinity;
 
     static std::atomic<bool> m_stop;
     int m_port;
+    bool m_reusePort;
+    int m_backlog;
     char* m_srcDir;
-    int m_listenFd;
+    std::vector<int> m_listenFds;
     int m_timeoutMS;
     const int MAX_FD;
-    size_t m_userCount;
-    std::unordered_map<int, HttpConnect*> mp_users;
-    
+
     uint32_t m_listenEvent;
     uint32_t m_connEvent;
 
     bool initSocket();
-    int setFdNonBlock(int fd);
+    int createListenFd();
     void initEventMode();
-    void extentTime(HttpConnect* client);
-
-    void dealListen();
-    void closeConn(const std::string& message, HttpConnect* client);
-    void dealRead(HttpConnect* client);
-    void dealWrite(HttpConnect* client);
-    void onProcess(HttpConnect* client);
-    void sendError(int fd, const char* info);
-
-    void addClient(int fd, sockaddr_in addr);
-    void onRead(HttpConnect* client);
-    void onWrite(HttpConnect* client);
-};
\ No newline at end of file
+    void initLoops(int loopNum, int threadNum, size_t objectNum);
+
+    void dealListen(int listenFd, EventLoop* owner);
+    // 完成模式下multishot accept得到的新连接
+    void onAccept(int fd, EventLoop* owner);
+    // 把新连接交给事件循环，连接数已满时返回false
+    bool dispatch(int fd, const sockaddr_in& addr, EventLoop* owner);
+    size_t userCount() const;
+    EventLoop* nextLoop();
+};
@@ -0,0 +1,87 @@
+#include "timer/cachedClock.h"
+#include <stdio.h>
+#include <string.h>
+
+// 事件循环线程自己的时间，其它线程为0
+static thread_local int64_t t_monoMS = 0;
+static thread_local time_t t_seconds = 0;
+
+// 每个线程缓存自己格式化好的时间，秒数变化时才重新生成
+struct ClockStrings {
+    time_t localSec = -1;
+    tm local = {};
+    // 按每个字段都是最长的int计算，避免格式截断
+    char logTime[80] = {0};
+
+    time_t dateSec = -1;
+    char date[64] = {0};
+    size_t dateLen = 0;
+};
+static thread_local ClockStrings t_strings;
+
+int64_t CachedClock::readMonoMS()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+time_t CachedClock::readSeconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return ts.tv_sec;
+}
+
+void CachedClock::update()
+{
+    t_seconds = readSeconds();
+    t_monoMS = readMonoMS();
+}
+
+int64_t CachedClock::nowMS()
+{
+    return t_monoMS ? t_monoMS : readMonoMS();
+}
+
+time_t CachedClock::seconds()
+{
+    return t_seconds ? t_seconds : readSeconds();
+}
+
+const tm& CachedClock::localTime()
+{
+    time_t sec = seconds();
+    if (sec != t_strings.localSec) {
+        t_strings.localSec = sec;
+        localtime_r(&sec, &t_strings.local);
+        const tm& t = t_strings.local;
+        snprintf(t_strings.logTime, sizeof(t_strings.logTime), "%04d-%02d-%02d %02d:%02d:%02d ",
+                 t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec);
+    }
+    return t_strings.local;
+}
+
+const char* CachedClock::logTime()
+{
+    localTime();
+    return t_strings.logTime;
+}
+
+const char* CachedClock::dateHeader()
+{
+    time_t sec = seconds();
+    if (sec != t_strings.dateSec) {
+        t_strings.dateSec = sec;
+        tm t;
+        gmtime_r(&sec, &t);
+        t_strings.dateLen = strftime(t_strings.date, sizeof(t_strings.date), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &t);
+    }
+    return t_strings.date;
+}
+
+size_t CachedClock::dateHeaderLen()
+{
+    dateHeader();
+    return t_strings.dateLen;
+}
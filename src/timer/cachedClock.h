@@ -0,0 +1,34 @@
+#pragma once
+#include <time.h>
+#include <stdint.h>
+
+/*
+热路径上使用的粗粒度时钟，事件循环每次从等待中返回时刷新一次
+定时器读取缓存的CLOCK_MONOTONIC_COARSE毫秒数，日志和HTTP Date头读取缓存的墙上时间秒数，
+格式化好的字符串每个线程每秒只生成一次
+缓存的时间是每个事件循环线程自己的，多个从reactor不会每次迭代都写同一个缓存行
+没有事件循环的线程（线程池、日志线程）每次直接读取粗粒度时钟，走vDSO不进入内核，
+读到的是当前时间，不会因为事件循环阻塞在等待中而落后
+*/
+class CachedClock {
+public:
+    // 由事件循环调用，刷新本线程的时间
+    static void update();
+
+    // 单调时间，毫秒
+    static int64_t nowMS();
+    // 墙上时间，秒
+    static time_t seconds();
+
+    // 本地时间
+    static const tm& localTime();
+    // 日志行首的时间 "2024-10-31 12:00:00 "
+    static const char* logTime();
+    // HTTP Date头 "Date: Thu, 31 Oct 2024 04:00:00 GMT\r\n"
+    static const char* dateHeader();
+    static size_t dateHeaderLen();
+
+private:
+    static int64_t readMonoMS();
+    static time_t readSeconds();
+};
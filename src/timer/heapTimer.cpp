@@ -10,12 +10,12 @@ void HeapTimer::SwapNode_(size_t i, size_t j) {
 
 void HeapTimer::siftup_(size_t i) {
     assert(i >= 0 && i < heap_.size());
-    size_t parent = (i-1) / 2;
-    while(parent >= 0) {
+    // 下标是无符号数，到根结点时必须停止
+    while(i > 0) {
+        size_t parent = (i-1) / 2;
         if(heap_[parent] > heap_[i]) {
             SwapNode_(i, parent);
             i = parent;
-            parent = (i-1)/2;
         } else {
             break;
         }
@@ -36,8 +36,9 @@ bool HeapTimer::siftdown_(size_t i, size_t n) {
             SwapNode_(index, child);
             index = child;
             child = 2*child+1;
+        } else {
+            break;
         }
-        break;  // 需要跳出循环
     }
     return index > i;
 }
@@ -125,10 +126,11 @@ void HeapTimer::clear() {
 // 根节点的剩余时间
 int HeapTimer::GetNextTick() {
     tick();
-    size_t res = -1;
+    // 用有符号数保存，已经过期时返回0而不是一个很大的数
+    int64_t res = -1;
     if(!heap_.empty()) {
         res = std::chrono::duration_cast<MS>(heap_.front().expires - Clock::now()).count();
         if(res < 0) { res = 0; }
     }
-    return res;
+    return static_cast<int>(res);
 }
\ No newline at end of file
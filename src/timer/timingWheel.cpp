@@ -0,0 +1,204 @@
+#include "timer/timingWheel.h"
+
+TimingWheel::TimingWheel(const Callback& cb, int tickMS):
+    m_callback(cb), m_tickMS(tickMS > 0 ? tickMS : 1), m_startMS(CachedClock::nowMS()), m_current(0), m_size(0)
+{
+    for (auto& head : m_root) {
+        initList(&head);
+    }
+    for (auto& level : m_levels) {
+        for (auto& head : level) {
+            initList(&head);
+        }
+    }
+}
+
+TimingWheel::~TimingWheel()
+{
+    // 结点属于使用者，只需要断开链接
+    auto clearList = [](WheelNode* head) {
+        while (!emptyList(head)) {
+            unlink(head->next);
+        }
+    };
+    for (auto& head : m_root) {
+        clearList(&head);
+    }
+    for (auto& level : m_levels) {
+        for (auto& head : level) {
+            clearList(&head);
+        }
+    }
+}
+
+// 使用事件循环缓存的单调时间，添加和刷新定时器时不需要读取时钟
+uint64_t TimingWheel::now() const
+{
+    return (CachedClock::nowMS() - m_startMS) / m_tickMS;
+}
+
+void TimingWheel::add(WheelNode* node, int timeoutMS)
+{
+    assert(node);
+    uint64_t ticks = (timeoutMS + m_tickMS - 1) / m_tickMS;
+    uint64_t expire = now() + (ticks > MAX_TICKS ? MAX_TICKS : ticks);
+    if (node->linked()) {
+        // 延后到期只记录新的时间，到达原来的槽时再移动
+        if (expire >= node->expire) {
+            node->expire = expire;
+            return;
+        }
+        unlink(node);
+        -- m_size;
+    }
+    node->expire = expire;
+    link(node);
+    ++ m_size;
+}
+
+void TimingWheel::del(WheelNode* node)
+{
+    assert(node);
+    if (node->linked()) {
+        unlink(node);
+        -- m_size;
+    }
+}
+
+// 根据到期时间和当前tick的距离选择所在的层
+void TimingWheel::link(WheelNode* node)
+{
+    uint64_t expire = node->expire;
+    if (expire <= m_current) {
+        // 已经到期，放在下一个要处理的槽中
+        expire = m_current + 1;
+    }
+    uint64_t delta = expire - m_current;
+    if (delta > MAX_TICKS) {
+        expire = m_current + MAX_TICKS;
+        delta = MAX_TICKS;
+    }
+
+    if (delta < ROOT_SIZE) {
+        pushBack(&m_root[expire & (ROOT_SIZE - 1)], node);
+        return;
+    }
+    for (int level = 0; level < WHEEL_LEVELS - 1; ++ level) {
+        int shift = WHEEL_ROOT_BITS + WHEEL_LEVEL_BITS * level;
+        if (delta < (1ull << (shift + WHEEL_LEVEL_BITS)) || level == WHEEL_LEVELS - 2) {
+            pushBack(&m_levels[level][(expire >> shift) & (LEVEL_SIZE - 1)], node);
+            return;
+        }
+    }
+}
+
+// 上一层的一个槽到期，结点重新分配到下面的层
+void TimingWheel::cascade(int level, int index)
+{
+    WheelNode list;
+    initList(&list);
+    splice(&m_levels[level][index], &list);
+    while (!emptyList(&list)) {
+        WheelNode* node = list.next;
+        unlink(node);
+        link(node);
+    }
+}
+
+void TimingWheel::expire(uint64_t tick)
+{
+    // 低层转完一圈时从上一层取下结点
+    for (int level = 0; level < WHEEL_LEVELS - 1; ++ level) {
+        int shift = WHEEL_ROOT_BITS + WHEEL_LEVEL_BITS * level;
+        if (tick & ((1ull << shift) - 1)) break;
+        cascade(level, (tick >> shift) & (LEVEL_SIZE - 1));
+    }
+
+    // 整个槽一次取下，回调中删除其它结点也是安全的
+    WheelNode list;
+    initList(&list);
+    splice(&m_root[tick & (ROOT_SIZE - 1)], &list);
+    while (!emptyList(&list)) {
+        WheelNode* node = list.next;
+        unlink(node);
+        if (node->expire > tick) {
+            // 超时时间被刷新过
+            link(node);
+            continue;
+        }
+        -- m_size;
+        m_callback(node);
+    }
+}
+
+void TimingWheel::tick()
+{
+    uint64_t target = now();
+    if (m_size == 0) {
+        m_current = target;
+        return;
+    }
+    while (m_current < target) {
+        ++ m_current;
+        expire(m_current);
+    }
+}
+
+int TimingWheel::GetNextTick()
+{
+    tick();
+    if (m_size == 0) {
+        return -1;
+    }
+    // 最低一层找下一个非空的槽，上面的层找下一个需要迁移的非空槽，取最早的一个
+    uint64_t next = UINT64_MAX;
+    for (uint64_t t = m_current + 1; t < m_current + ROOT_SIZE; ++ t) {
+        if (!emptyList(&m_root[t & (ROOT_SIZE - 1)])) {
+            next = t;
+            break;
+        }
+    }
+    for (int level = 0; level < WHEEL_LEVELS - 1; ++ level) {
+        int shift = WHEEL_ROOT_BITS + WHEEL_LEVEL_BITS * level;
+        for (uint64_t k = 1; k <= LEVEL_SIZE; ++ k) {
+            uint64_t t = ((m_current >> shift) + k) << shift;
+            if (t >= next) break;
+            if (!emptyList(&m_levels[level][(t >> shift) & (LEVEL_SIZE - 1)])) {
+                next = t;
+                break;
+            }
+        }
+    }
+    if (next == UINT64_MAX) {
+        return -1;
+    }
+    int64_t ms = static_cast<int64_t>(next * m_tickMS) - (CachedClock::nowMS() - m_startMS);
+    return ms > 0 ? static_cast<int>(ms) : 0;
+}
+
+void TimingWheel::unlink(WheelNode* node)
+{
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = node->next = nullptr;
+}
+
+void TimingWheel::pushBack(WheelNode* head, WheelNode* node)
+{
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+void TimingWheel::splice(WheelNode* head, WheelNode* to)
+{
+    if (emptyList(head)) return;
+    WheelNode* first = head->next;
+    WheelNode* last = head->prev;
+    first->prev = to->prev;
+    to->prev->next = first;
+    last->next = to;
+    to->prev = last;
+    initList(head);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <stdint.h>
+#include <assert.h>
+#include <functional>
+#include "timer/cachedClock.h"
+
+// 最低一层的槽数和上面每层的槽数
+#define WHEEL_ROOT_BITS 8
+#define WHEEL_LEVEL_BITS 6
+#define WHEEL_LEVELS 4
+
+/*
+侵入式定时器结点，嵌入在使用者的对象中，定时器本身不分配内存
+data由使用者解释
+*/
+struct WheelNode {
+    WheelNode* prev = nullptr;
+    WheelNode* next = nullptr;
+    uint64_t expire = 0;    // 到期的tick
+    uint64_t data = 0;
+
+    bool linked() const { return next != nullptr; }
+};
+
+/*
+分层时间轮，添加、刷新和删除都是O(1)
+最低一层256个槽，每个槽一个tick；上面三层各64个槽，每个槽覆盖下一层一整圈
+低层转完一圈时把上一层对应槽中的结点重新分配到下面的层
+刷新超时时间只修改结点中的到期时间，结点到达原来的槽时发现还没有到期再挂到新的位置，
+所以频繁刷新的连接几乎没有开销
+所有操作只能在同一个线程中进行
+*/
+class TimingWheel {
+public:
+    typedef std::function<void(WheelNode*)> Callback;
+
+    explicit TimingWheel(const Callback& cb, int tickMS = 1);
+    ~TimingWheel();
+
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    // 结点已经在时间轮中时相当于刷新超时时间
+    void add(WheelNode* node, int timeoutMS);
+    void del(WheelNode* node);
+    // 处理所有到期的结点，到期结点在回调之前已经从时间轮中移除
+    void tick();
+    // 处理到期的结点并返回距离下一次需要处理的毫秒数，没有结点时返回-1
+    // 下一次可能是结点到期，也可能是上层的结点需要迁移到下层，空的槽不会引起唤醒
+    int GetNextTick();
+    size_t size() const { return m_size; }
+
+private:
+    static const int ROOT_SIZE = 1 << WHEEL_ROOT_BITS;
+    static const int LEVEL_SIZE = 1 << WHEEL_LEVEL_BITS;
+    static const uint64_t MAX_TICKS = (1ull << (WHEEL_ROOT_BITS + WHEEL_LEVEL_BITS * (WHEEL_LEVELS - 1))) - 1;
+
+    Callback m_callback;
+    int m_tickMS;
+    int64_t m_startMS;
+    // 已经处理过的tick
+    uint64_t m_current;
+    size_t m_size;
+
+    // 每个槽是一个带哨兵的双向循环链表
+    WheelNode m_root[ROOT_SIZE];
+    WheelNode m_levels[WHEEL_LEVELS - 1][LEVEL_SIZE];
+
+    uint64_t now() const;
+    void link(WheelNode* node);
+    void cascade(int level, int index);
+    void expire(uint64_t tick);
+
+    static void initList(WheelNode* head) { head->prev = head->next = head; }
+    static bool emptyList(const WheelNode* head) { return head->next == head; }
+    static void unlink(WheelNode* node);
+    static void pushBack(WheelNode* head, WheelNode* node);
+    // 把head中的结点全部移到to中
+    static void splice(WheelNode* head, WheelNode* to);
+};
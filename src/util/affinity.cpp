@@ -0,0 +1,114 @@
+#include "util/affinity.h"
+#include <sched.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include "log/log.h"
+
+namespace affinity {
+
+bool parseCpuList(const std::string& list, std::vector<int>& cpus)
+{
+    std::vector<int> res;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        std::string item = list.substr(pos, end - pos);
+        pos = end + 1;
+        if (item.empty()) continue;
+
+        char* stop;
+        long first = strtol(item.c_str(), &stop, 10);
+        long last = first;
+        if (*stop == '-') {
+            last = strtol(stop + 1, &stop, 10);
+        }
+        if (*stop != '\0' || first < 0 || last < first || last >= CPU_SETSIZE) {
+            return false;
+        }
+        for (long cpu = first; cpu <= last; ++ cpu) {
+            res.push_back(static_cast<int>(cpu));
+        }
+    }
+    cpus.swap(res);
+    return true;
+}
+
+bool parse(const char* spec, Config& config)
+{
+    if (spec == nullptr) return true;
+    Config res;
+    std::string str(spec);
+    size_t pos = 0;
+    while (pos < str.size()) {
+        size_t end = str.find(';', pos);
+        if (end == std::string::npos) end = str.size();
+        std::string item = str.substr(pos, end - pos);
+        pos = end + 1;
+        if (item.empty()) continue;
+
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) return false;
+        std::string key = item.substr(0, eq);
+        std::string value = item.substr(eq + 1);
+        if (key == "loops") {
+            if (!parseCpuList(value, res.loops)) return false;
+        } else if (key == "workers") {
+            if (!parseCpuList(value, res.workers)) return false;
+        } else if (key == "log") {
+            std::vector<int> cpus;
+            if (!parseCpuList(value, cpus) || cpus.size() != 1) return false;
+            res.log = cpus[0];
+        } else {
+            return false;
+        }
+    }
+    config = res;
+    return true;
+}
+
+int cpuCount()
+{
+    long n = sysconf(_SC_NPROCESSORS_CONF);
+    return n > 0 ? static_cast<int>(n) : 1;
+}
+
+// /sys/devices/system/cpu/cpuN/下有一个nodeM目录
+int numaNode(int cpu)
+{
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) return 0;
+    int node = 0;
+    while (dirent* entry = readdir(dir)) {
+        if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+bool pinThread(int cpu)
+{
+    return pinThread(pthread_self(), cpu);
+}
+
+bool pinThread(pthread_t thread, int cpu)
+{
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int ret = pthread_setaffinity_np(thread, sizeof(set), &set);
+    if (ret != 0) {
+        LOG_WARN("Pin thread to cpu %d error: %s", cpu, strerror(ret));
+        return false;
+    }
+    return true;
+}
+
+}
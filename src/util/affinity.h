@@ -0,0 +1,36 @@
+#pragma once
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+/*
+线程绑核和NUMA节点查询
+绑核之后再由线程自己分配内存，按照Linux默认的首次访问策略，内存就落在该CPU所在的NUMA节点上
+配置格式："loops=0-3;workers=4-7,12;log=8"，每一项都可以省略
+*/
+namespace affinity {
+
+struct Config {
+    // 第i个事件循环绑定到loops[i % loops.size()]，为空时不绑定
+    std::vector<int> loops;
+    std::vector<int> workers;
+    // 小于0时不绑定
+    int log = -1;
+
+    bool empty() const { return loops.empty() && workers.empty() && log < 0; }
+};
+
+// 解析失败时返回false，config保持不变
+bool parse(const char* spec, Config& config);
+// "0-3,8,10-11"
+bool parseCpuList(const std::string& list, std::vector<int>& cpus);
+
+int cpuCount();
+// cpu所在的NUMA节点，系统没有NUMA信息时返回0
+int numaNode(int cpu);
+
+// 绑定当前线程
+bool pinThread(int cpu);
+bool pinThread(pthread_t thread, int cpu);
+
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#define CACHE_LINE_SIZE 64
+// 阻塞的push和pop睡眠前的重试次数
+#define MPMC_SPINS 16
+
+/*
+基于futex的事件计数，让无锁队列的消费者和生产者在没有事件时可以睡眠
+等待方：key = prepareWait()，再检查一次条件，条件仍不满足时wait(key)，否则cancelWait()
+通知方：修改状态后调用notify，没有等待者时只是一次原子读，不进入内核
+*/
+class EventCount {
+public:
+    EventCount() : m_epoch(0), m_waiters(0) {}
+
+    EventCount(const EventCount&) = delete;
+    EventCount& operator=(const EventCount&) = delete;
+
+    uint32_t prepareWait() {
+        m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        return m_epoch.load(std::memory_order_seq_cst);
+    }
+
+    void cancelWait() {
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void wait(uint32_t key) {
+        while (m_epoch.load(std::memory_order_acquire) == key) {
+            futex(FUTEX_WAIT_PRIVATE, key);
+        }
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notifyOne() { notify(1); }
+    void notifyAll() { notify(INT_MAX); }
+
+    // 最多唤醒count个等待者
+    void notify(int count) {
+        // 和等待方的prepareWait配对，保证不会错过prepareWait之后修改的状态
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiters.load(std::memory_order_relaxed) == 0) return;
+        m_epoch.fetch_add(1, std::memory_order_release);
+        futex(FUTEX_WAKE_PRIVATE, count);
+    }
+
+private:
+    long futex(int op, uint32_t val) {
+        return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_epoch), op, val, nullptr, nullptr, 0);
+    }
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> m_epoch;
+    std::atomic<int> m_waiters;
+};
+
+/*
+有界多生产者多消费者无锁环形队列（Dmitry Vyukov的实现）
+每个槽有一个序号，生产者和消费者各自用一次CAS抢占位置，不会互相阻塞
+每个槽独占缓存行，相邻槽的读写不会产生伪共享
+tryPush/tryPop不阻塞；push/pop在队列满或空时通过EventCount睡眠
+close之后push失败，pop取完剩余元素后失败
+*/
+template <typename T>
+class MpmcQueue {
+public:
+    explicit MpmcQueue(size_t capacity = 1024);
+    ~MpmcQueue();
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    template <typename U>
+    bool tryPush(U&& item);
+    bool tryPop(T& item);
+
+    template <typename U>
+    bool push(U&& item);
+    bool pop(T& item);
+
+    void close();
+    bool closed() const { return m_closed.load(std::memory_order_acquire); }
+
+    // 并发时只是近似值
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return m_mask + 1; }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Slot {
+        std::atomic<size_t> seq;
+        T data;
+    };
+
+    Slot* m_slots;
+    size_t m_mask;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_head;   // 下一个出队的位置
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_tail;   // 下一个入队的位置
+    alignas(CACHE_LINE_SIZE) std::atomic<bool> m_closed;
+    EventCount m_notEmpty;
+    EventCount m_notFull;
+};
+
+
+template <typename T>
+MpmcQueue<T>::MpmcQueue(size_t capacity) : m_head(0), m_tail(0), m_closed(false)
+{
+    // 容量取2的幂
+    size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+    m_mask = cap - 1;
+    m_slots = new Slot[cap];
+    for (size_t i = 0; i < cap; ++ i) {
+        m_slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+MpmcQueue<T>::~MpmcQueue()
+{
+    delete[] m_slots;
+}
+
+template <typename T>
+template <typename U>
+bool MpmcQueue<T>::tryPush(U&& item)
+{
+    size_t pos = m_tail.load(std::memory_order_relaxed);
+    while (true) {
+        Slot& slot = m_slots[pos & m_mask];
+        size_t seq = slot.seq.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.data = std::forward<U>(item);
+                slot.seq.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0) {
+            // 槽中的元素还没有被取走，队列已满
+            return false;
+        }
+        else {
+            pos = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+bool MpmcQueue<T>::tryPop(T& item)
+{
+    size_t pos = m_head.load(std::memory_order_relaxed);
+    while (true) {
+        Slot& slot = m_slots[pos & m_mask];
+        size_t seq = slot.seq.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0) {
+            if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                item = std::move(slot.data);
+                // 下一圈的生产者可以使用这个槽
+                slot.seq.store(pos + m_mask + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0) {
+            // 队列为空
+            return false;
+        }
+        else {
+            pos = m_head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+template <typename U>
+bool MpmcQueue<T>::push(U&& item)
+{
+    int spins = 0;
+    while (!closed()) {
+        if (tryPush(std::forward<U>(item))) {
+            m_notEmpty.notifyOne();
+            return true;
+        }
+        if (spins++ < MPMC_SPINS) {
+            std::this_thread::yield();
+            continue;
+        }
+        spins = 0;
+        uint32_t key = m_notFull.prepareWait();
+        if (closed() || size() < capacity()) {
+            m_notFull.cancelWait();
+            continue;
+        }
+        m_notFull.wait(key);
+    }
+    return false;
+}
+
+template <typename T>
+bool MpmcQueue<T>::pop(T& item)
+{
+    int spins = 0;
+    while (true) {
+        if (tryPop(item)) {
+            m_notFull.notifyOne();
+            return true;
+        }
+        // 先让出几次CPU，生产者很快就会放入新元素时不需要睡眠和唤醒
+        if (spins++ < MPMC_SPINS) {
+            std::this_thread::yield();
+            continue;
+        }
+        spins = 0;
+        uint32_t key = m_notEmpty.prepareWait();
+        if (!empty()) {
+            m_notEmpty.cancelWait();
+            continue;
+        }
+        if (closed()) {
+            m_notEmpty.cancelWait();
+            return false;
+        }
+        m_notEmpty.wait(key);
+    }
+}
+
+template <typename T>
+void MpmcQueue<T>::close()
+{
+    m_closed.store(true, std::memory_order_release);
+    m_notEmpty.notifyAll();
+    m_notFull.notifyAll();
+}
+
+template <typename T>
+size_t MpmcQueue<T>::size() const
+{
+    size_t head = m_head.load(std::memory_order_acquire);
+    size_t tail = m_tail.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+}
@@ -0,0 +1,211 @@
+#include "util/scan.h"
+#include <string.h>
+#include <stdint.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_X86 1
+#endif
+
+namespace scan {
+
+// 与SSE4.2实现中的字节范围保持一致
+static const char CTL_RANGES[] = {'\x00', '\x08', '\x0a', '\x1f', '\x7f', '\x7f'};
+static const char NON_TOKEN_RANGES[] = {'\x00', ' ', '"', '"', '(', ')', ',', ',', '/', '/',
+                                        ':', '@', '[', ']', '{', '\xff'};
+
+static bool inRanges(unsigned char c, const char* ranges, size_t len)
+{
+    for (size_t i = 0; i < len; i += 2) {
+        if (c >= (unsigned char)ranges[i] && c <= (unsigned char)ranges[i + 1]) return true;
+    }
+    return false;
+}
+
+struct Tables {
+    bool token[256];
+    bool ctl[256];
+    // AVX2查表用：低4位查出高4位的位图
+    uint8_t tokenLo[16];
+    uint8_t tokenHi[16];
+
+    Tables() {
+        memset(tokenLo, 0, sizeof(tokenLo));
+        for (int c = 0; c < 256; ++ c) {
+            token[c] = !inRanges(c, NON_TOKEN_RANGES, sizeof(NON_TOKEN_RANGES));
+            ctl[c] = inRanges(c, CTL_RANGES, sizeof(CTL_RANGES));
+            if (token[c]) tokenLo[c & 0x0f] |= 1 << (c >> 4);
+        }
+        for (int hi = 0; hi < 16; ++ hi) {
+            tokenHi[hi] = hi < 8 ? 1 << hi : 0;
+        }
+    }
+};
+static const Tables TABLES;
+
+bool isToken(unsigned char c)
+{
+    return TABLES.token[c];
+}
+
+static const char* findCtlScalar(const char* p, const char* end)
+{
+    for (; p < end; ++ p) {
+        if (TABLES.ctl[(unsigned char)*p]) return p;
+    }
+    return end;
+}
+
+static const char* findNonTokenScalar(const char* p, const char* end)
+{
+    for (; p < end; ++ p) {
+        if (!TABLES.token[(unsigned char)*p]) return p;
+    }
+    return end;
+}
+
+#ifdef SCAN_X86
+__attribute__((target("sse4.2")))
+static const char* findRangesSse42(const char* p, const char* end, const char* ranges, int rangesLen)
+{
+    __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ranges));
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int idx = _mm_cmpestri(r, rangesLen, v, 16, _SIDD_LEAST_SIGNIFICANT | _SIDD_CMP_RANGES | _SIDD_UBYTE_OPS);
+        if (idx != 16) return p + idx;
+    }
+    return p;
+}
+
+__attribute__((target("sse4.2")))
+static const char* findCtlSse42(const char* p, const char* end)
+{
+    // cmpestri总是读取16字节的范围
+    char ranges[16] = {0};
+    memcpy(ranges, CTL_RANGES, sizeof(CTL_RANGES));
+    return findCtlScalar(findRangesSse42(p, end, ranges, sizeof(CTL_RANGES)), end);
+}
+
+__attribute__((target("sse4.2")))
+static const char* findNonTokenSse42(const char* p, const char* end)
+{
+    return findNonTokenScalar(findRangesSse42(p, end, NON_TOKEN_RANGES, sizeof(NON_TOKEN_RANGES)), end);
+}
+
+__attribute__((target("avx2")))
+static const char* findCtlAvx2(const char* p, const char* end)
+{
+    const __m256i ctlMax = _mm256_set1_epi8(0x1f);
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        // 无符号比较v <= 0x1f，去掉'\t'，再加上DEL
+        __m256i ctl = _mm256_cmpeq_epi8(_mm256_min_epu8(v, ctlMax), v);
+        ctl = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, tab), ctl);
+        ctl = _mm256_or_si256(ctl, _mm256_cmpeq_epi8(v, del));
+        uint32_t mask = _mm256_movemask_epi8(ctl);
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return findCtlScalar(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* findNonTokenAvx2(const char* p, const char* end)
+{
+    const __m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(TABLES.tokenLo)));
+    const __m256i hi = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(TABLES.tokenHi)));
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i bitsLo = _mm256_shuffle_epi8(lo, _mm256_and_si256(v, nibble));
+        __m256i bitsHi = _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+        __m256i nonToken = _mm256_cmpeq_epi8(_mm256_and_si256(bitsLo, bitsHi), zero);
+        uint32_t mask = _mm256_movemask_epi8(nonToken);
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return findNonTokenScalar(p, end);
+}
+#endif
+
+typedef const char* (*FindFunc)(const char*, const char*);
+
+struct Dispatch {
+    Impl impl = SCALAR;
+    FindFunc ctl = findCtlScalar;
+    FindFunc nonToken = findNonTokenScalar;
+};
+// 静态初始化完成之前使用逐字节实现
+static Dispatch dispatch;
+
+static bool supported(Impl impl)
+{
+#ifdef SCAN_X86
+    __builtin_cpu_init();
+    if (impl == AVX2) return __builtin_cpu_supports("avx2");
+    if (impl == SSE42) return __builtin_cpu_supports("sse4.2");
+#endif
+    return impl == SCALAR;
+}
+
+bool setImpl(Impl impl)
+{
+    if (!supported(impl)) return false;
+    Dispatch d;
+    d.impl = impl;
+#ifdef SCAN_X86
+    if (impl == AVX2) {
+        d.ctl = findCtlAvx2;
+        d.nonToken = findNonTokenAvx2;
+    } else if (impl == SSE42) {
+        d.ctl = findCtlSse42;
+        d.nonToken = findNonTokenSse42;
+    }
+#endif
+    dispatch = d;
+    return true;
+}
+
+static struct AutoSelect {
+    AutoSelect() {
+        setImpl(AVX2) || setImpl(SSE42);
+    }
+} autoSelect;
+
+Impl impl()
+{
+    return dispatch.impl;
+}
+
+const char* implName(Impl impl)
+{
+    switch (impl) {
+    case AVX2: return "avx2";
+    case SSE42: return "sse4.2";
+    default: return "scalar";
+    }
+}
+
+const char* findCtl(const char* p, const char* end)
+{
+    return dispatch.ctl(p, end);
+}
+
+const char* findNonToken(const char* p, const char* end)
+{
+    return dispatch.nonToken(p, end);
+}
+
+// memchr在glibc中已经是向量化的实现
+const char* findCRLF(const char* p, const char* end)
+{
+    while (p < end) {
+        const char* cr = static_cast<const char*>(memchr(p, '\r', end - p));
+        if (!cr || cr + 1 == end) return end;
+        if (cr[1] == '\n') return cr;
+        p = cr + 1;
+    }
+    return end;
+}
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <stddef.h>
+
+/*
+请求解析使用的字节扫描函数，按CPU支持情况在运行时选择AVX2、SSE4.2或者逐字节实现
+SIMD实现每次比较16或32个字节，思路与picohttpparser相同
+所有函数在找不到时返回end
+*/
+namespace scan {
+
+enum Impl {
+    SCALAR,
+    SSE42,
+    AVX2,
+};
+
+// 第一个控制字符（'\t'除外）或DEL，用来一次扫描同时找到行尾和非法字符
+const char* findCtl(const char* p, const char* end);
+// 第一个不属于token的字符，用于方法名和头部名称，RFC 7230中的'|'、'~'也当作分隔符
+const char* findNonToken(const char* p, const char* end);
+// "\r\n"的起始位置
+const char* findCRLF(const char* p, const char* end);
+
+bool isToken(unsigned char c);
+
+// 当前使用的实现，setImpl用于测试和性能对比，CPU不支持时返回false
+Impl impl();
+const char* implName(Impl impl);
+bool setImpl(Impl impl);
+
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <unistd.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "buffer/chainBuffer.h"
+#include "buffer/linearBuffer.h"
+#include "bench_util.h"
+
+static const char STATE_LINE[] = "HTTP/1.1 200 OK\r\n";
+static const char DATE[] = "Date: Sun, 18 Oct 2026 12:00:00 GMT\r\n";
+static const char KEEP_ALIVE[] = "Connection: keep-alive\r\nkeep-alive: max=6, timeout=120\r\n";
+static const char HEADER[] = "Content-type: text/css\r\nContent-length: 4096\r\n\r\n";
+
+static void drain(int fd)
+{
+    char buf[65536];
+    while (read(fd, buf, sizeof(buf)) > 0) {}
+}
+
+// 原来的方式：头部逐段复制进LinearBuffer，再和文件内容组成两个iovec发送
+static void sendLinear(int fd, int pipeline, const std::string& body)
+{
+    LinearBuffer buff;
+    std::vector<iovec> iov;
+    std::vector<size_t> offsets;
+    for (int i = 0; i < pipeline; ++ i) {
+        offsets.push_back(buff.readAbleBytes());
+        buff.append(std::string("HTTP/1.1 ") + std::to_string(200) + " " + "OK" + "\r\n");
+        buff.append(DATE, sizeof(DATE) - 1);
+        buff.append("Connection: ");
+        buff.append("keep-alive\r\n");
+        buff.append("keep-alive: max=6, timeout=120\r\n");
+        buff.append(HEADER, sizeof(HEADER) - 1);
+    }
+    offsets.push_back(buff.readAbleBytes());
+    for (int i = 0; i < pipeline; ++ i) {
+        iov.push_back({const_cast<char*>(buff.readAddress() + offsets[i]), offsets[i + 1] - offsets[i]});
+        iov.push_back({const_cast<char*>(body.data()), body.size()});
+    }
+    writev(fd, iov.data(), iov.size());
+    buff.retrieveAll();
+}
+
+// 链式缓冲区：只复制Date头，其余都是引用
+static void sendChain(int fd, int pipeline, const std::shared_ptr<std::string>& body)
+{
+    ChainBuffer buff;
+    for (int i = 0; i < pipeline; ++ i) {
+        buff.appendStatic(STATE_LINE, sizeof(STATE_LINE) - 1);
+        buff.append(DATE, sizeof(DATE) - 1);
+        buff.appendStatic(KEEP_ALIVE, sizeof(KEEP_ALIVE) - 1);
+        buff.appendStatic(HEADER, sizeof(HEADER) - 1);
+        buff.appendRef(body->data(), body->size(), body);
+    }
+    int err;
+    buff.writeFd(fd, &err);
+}
+
+TEST(ChainBufferBench, BuildAndFlush) {
+    int fds[2];
+    ASSERT_TRUE(makeSocketPair(fds));
+    auto body = std::make_shared<std::string>(4096, 'x');
+
+    const int rounds = 20000;
+    for (int pipeline : {1, 4, 16}) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++ i) {
+            sendLinear(fds[0], pipeline, *body);
+            drain(fds[1]);
+        }
+        double linearMs = elapsedMs(start);
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++ i) {
+            sendChain(fds[0], pipeline, body);
+            drain(fds[1]);
+        }
+        double chainMs = elapsedMs(start);
+        std::cout << rounds << " flushes of " << pipeline << " responses: linear buffer " << linearMs
+                  << " ms, chain buffer " << chainMs << " ms" << std::endl;
+    }
+    close(fds[0]);
+    close(fds[1]);
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <unistd.h>
+#include <string>
+#include "buffer/buffer.h"
+#include "buffer/linearBuffer.h"
+#include "bench_util.h"
+
+static const char REQUEST[] =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:91.0) Gecko/20100101 Firefox/91.0\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Connection: keep-alive\r\n\r\n";
+
+// 流水线请求按不对齐的块写入，每次只取出完整的行，剩下半行留在缓冲区中
+static std::string makeStream(size_t bytes)
+{
+    std::string stream;
+    while (stream.size() < bytes) {
+        stream += REQUEST;
+    }
+    return stream;
+}
+
+TEST(CircleBufferBench, AppendAndParse) {
+    std::string stream = makeStream(1 << 20);
+    const int rounds = 50;
+    for (size_t chunk : {97, 1000, 3001}) {
+        size_t lines = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++ r) {
+            LinearBuffer buff(16384);
+            for (size_t off = 0; off < stream.size(); off += chunk) {
+                buff.append(stream.data() + off, std::min(chunk, stream.size() - off));
+                while (buff.readAbleBytes() > 0) {
+                    size_t before = buff.readAbleBytes();
+                    buff.getByEndFlag("\r\n");
+                    if (buff.readAbleBytes() == before) break;
+                    ++ lines;
+                }
+            }
+        }
+        double linearMs = elapsedMs(start);
+
+        size_t circleLines = 0;
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++ r) {
+            CircleBuffer buff(16384);
+            for (size_t off = 0; off < stream.size(); off += chunk) {
+                buff.Append(stream.data() + off, std::min(chunk, stream.size() - off));
+                while (buff.readableBytes() > 0) {
+                    size_t before = buff.readableBytes();
+                    buff.getByEndBytes();
+                    if (buff.readableBytes() == before) break;
+                    ++ circleLines;
+                }
+            }
+        }
+        double circleMs = elapsedMs(start);
+        EXPECT_EQ(lines, circleLines);
+        std::cout << rounds << " x 1MB in " << chunk << "B chunks: linear buffer " << linearMs
+                  << " ms, circle buffer " << circleMs << " ms" << std::endl;
+    }
+}
+
+TEST(CircleBufferBench, ReadAndParse) {
+    int fds[2];
+    ASSERT_TRUE(makeSocketPair(fds));
+    std::string stream = makeStream(1 << 20);
+    const size_t chunk = 3001;
+    const int rounds = 20;
+
+    auto run = [&](auto& buff, auto readIn, auto parse, auto bytes) {
+        for (size_t off = 0; off < stream.size(); off += chunk) {
+            size_t len = std::min(chunk, stream.size() - off);
+            ASSERT_EQ(write(fds[0], stream.data() + off, len), (ssize_t)len);
+            while (readIn(buff) > 0) {}
+            while (bytes(buff) > 0) {
+                size_t before = bytes(buff);
+                parse(buff);
+                if (bytes(buff) == before) break;
+            }
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++ r) {
+        LinearBuffer buff(16384);
+        run(buff, [&](LinearBuffer& b) { int err; return b.readFd(fds[1], &err); },
+            [](LinearBuffer& b) { b.getByEndFlag("\r\n"); },
+            [](LinearBuffer& b) { return b.readAbleBytes(); });
+    }
+    double linearMs = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++ r) {
+        CircleBuffer buff(16384);
+        run(buff, [&](CircleBuffer& b) { return b.writeIn(fds[1]); },
+            [](CircleBuffer& b) { b.getByEndBytes(); },
+            [](CircleBuffer& b) { return b.readableBytes(); });
+    }
+    double circleMs = elapsedMs(start);
+    std::cout << rounds << " x 1MB read from socket: linear buffer " << linearMs
+              << " ms, circle buffer " << circleMs << " ms" << std::endl;
+    close(fds[0]);
+    close(fds[1]);
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <strings.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "buffer/linearBuffer.h"
+#include "bench_util.h"
+
+static const char REQUEST[] =
+    "GET /css/bootstrap.min.css HTTP/1.1\r\n"
+    "Host: 127.0.0.1:1317\r\n"
+    "Connection: keep-alive\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/130.0.0.0\r\n"
+    "Accept: text/css,*/*;q=0.1\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n\r\n";
+
+// 小段追加，包括扩容
+TEST(LinearBufferBench, Append) {
+    const int rounds = 200000;
+    for (size_t len : {9, 64, 512}) {
+        std::string piece(len, 'x');
+        auto start = std::chrono::steady_clock::now();
+        LinearBuffer buff;
+        for (int i = 0; i < rounds; ++ i) {
+            buff.append(piece);
+            if (buff.readAbleBytes() >= (1 << 20)) {
+                buff.retrieveAll();
+            }
+        }
+        std::cout << rounds << " appends of " << len << "B: " << elapsedMs(start) << " ms" << std::endl;
+    }
+}
+
+// 一次大的上传，读到EAGAIN为止，和直接读进预先分配好的内存比较，差值就是缓冲区的开销
+TEST(LinearBufferBench, Read) {
+    int fds[2];
+    ASSERT_TRUE(makeSocketPair(fds, true));
+    const int rounds = 500;
+    std::vector<char> raw(1 << 20);
+    for (size_t size : {1000, 60000, 500000}) {
+        std::string data(size, 'x');
+        double rawMs = 0, bufferMs = 0;
+        for (int i = 0; i < rounds; ++ i) {
+            ASSERT_EQ(write(fds[0], data.data(), size), (ssize_t)size);
+            auto start = std::chrono::steady_clock::now();
+            size_t got = 0;
+            ssize_t len;
+            while ((len = read(fds[1], raw.data() + got, raw.size() - got)) > 0) {
+                got += len;
+            }
+            rawMs += elapsedMs(start);
+            ASSERT_EQ(got, size);
+
+            ASSERT_EQ(write(fds[0], data.data(), size), (ssize_t)size);
+            start = std::chrono::steady_clock::now();
+            LinearBuffer buff;
+            int err;
+            while (buff.readFd(fds[1], &err) > 0) {}
+            bufferMs += elapsedMs(start);
+            ASSERT_EQ(buff.readAbleBytes(), size);
+        }
+        std::cout << rounds << " reads of " << size << "B: raw read " << rawMs
+                  << " ms, readFd " << bufferMs << " ms" << std::endl;
+    }
+    close(fds[0]);
+    close(fds[1]);
+}
+
+// 缓冲区曾经扩大到1MB之后反复清空
+TEST(LinearBufferBench, Retrieve) {
+    const int rounds = 20000;
+    LinearBuffer buff;
+    buff.append(std::string(1 << 20, 'x'));
+    size_t capacity = buff.capacity();
+    std::vector<char> shadow(capacity);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++ i) {
+        buff.append(REQUEST, sizeof(REQUEST) - 1);
+        bzero(shadow.data(), capacity);
+        buff.retrieve(buff.readAbleBytes());
+    }
+    double bzeroMs = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++ i) {
+        buff.append(REQUEST, sizeof(REQUEST) - 1);
+        buff.retrieveAll();
+    }
+    double resetMs = elapsedMs(start);
+    std::cout << rounds << " resets of a " << capacity << "B buffer: with bzero " << bzeroMs
+              << " ms, retrieveAll " << resetMs << " ms" << std::endl;
+}
+
+// 连接的典型用法：读入流水线请求，逐行解析，空闲时收缩
+TEST(LinearBufferBench, Mixed) {
+    int fds[2];
+    ASSERT_TRUE(makeSocketPair(fds, true));
+    std::string stream;
+    for (int i = 0; i < 8; ++ i) {
+        stream += REQUEST;
+    }
+    const int rounds = 20000;
+    size_t lines = 0;
+    LinearBuffer buff;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++ i) {
+        // 最后一个请求只到一半，留在缓冲区中
+        size_t len = i % 2 ? stream.size() : stream.size() - 40;
+        ASSERT_EQ(write(fds[0], stream.data(), len), (ssize_t)len);
+        int err;
+        while (buff.readFd(fds[1], &err) > 0) {}
+        while (true) {
+            size_t before = buff.readAbleBytes();
+            buff.getByEndFlag("\r\n");
+            if (buff.readAbleBytes() == before) break;
+            ++ lines;
+        }
+        if (i % 2) buff.retrieveAll();
+        buff.shrinkToFit();
+    }
+    std::cout << rounds << " read/parse/shrink cycles (" << lines << " lines): "
+              << elapsedMs(start) << " ms" << std::endl;
+    close(fds[0]);
+    close(fds[1]);
+}
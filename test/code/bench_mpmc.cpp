@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "util/mpmcQueue.h"
+#include "log/blockqueue.h"
+#include "bench_util.h"
+
+// threads个生产者和threads个消费者通过同一个队列传递items个元素，检查每个元素都恰好被取出一次
+template <typename Queue>
+static double transfer(Queue& queue, int threads, int items)
+{
+    std::atomic<long long> sum(0);
+    std::atomic<int> received(0);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < threads; ++ i) {
+        workers.emplace_back([&queue, &sum, &received, items]() {
+            long value;
+            while (queue.pop(value)) {
+                sum += value;
+                if (++ received == items) break;
+            }
+        });
+    }
+    for (int i = 0; i < threads; ++ i) {
+        workers.emplace_back([&queue, i, threads, items]() {
+            for (long v = i; v < items; v += threads) {
+                queue.push(v);
+            }
+        });
+    }
+    while (received.load() < items) {
+        std::this_thread::yield();
+    }
+    double ms = elapsedMs(start);
+    // 唤醒还在等待的消费者
+    queue.close();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(sum.load(), static_cast<long long>(items) * (items - 1) / 2);
+    return ms;
+}
+
+// 和BlockQueue的接口保持一致
+struct RingQueue {
+    MpmcQueue<long> queue;
+    explicit RingQueue(size_t size) : queue(size) {}
+    void push(long v) { queue.push(v); }
+    bool pop(long& v) { return queue.pop(v); }
+    void close() { queue.close(); }
+};
+
+struct MutexQueue {
+    BlockQueue<long> queue;
+    explicit MutexQueue(size_t size) : queue(size, false) {}
+    void push(long v) { queue.push_back(v); }
+    bool pop(long& v) { return queue.pop(v); }
+    void close() { queue.close(); }
+};
+
+TEST(MpmcBench, Contention)
+{
+    const int items = 200000;
+    for (int threads : {1, 2, 4, 8, 16, 32, 64}) {
+        RingQueue ring(1024);
+        MutexQueue mutex(1024);
+        double ringMs = transfer(ring, threads, items);
+        double mutexMs = transfer(mutex, threads, items);
+        std::cout << threads << " producers x " << threads << " consumers, " << items << " items: mpmc ring "
+                  << ringMs << " ms, mutex deque " << mutexMs << " ms" << std::endl;
+    }
+}
+
+// 关闭后push失败，pop取完剩余的元素后失败
+TEST(MpmcBench, CloseDrains)
+{
+    MpmcQueue<int> queue(4);
+    EXPECT_EQ(queue.capacity(), 4u);
+    for (int i = 0; i < 4; ++ i) {
+        EXPECT_TRUE(queue.tryPush(i));
+    }
+    EXPECT_FALSE(queue.tryPush(4));
+    queue.close();
+    EXPECT_FALSE(queue.push(5));
+    int value;
+    for (int i = 0; i < 4; ++ i) {
+        EXPECT_TRUE(queue.pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.pop(value));
+}
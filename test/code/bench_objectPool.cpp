@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "pool/objectPool.h"
+#include "bench_util.h"
+
+struct Conn {
+    char data[256];
+};
+
+// 原来的实现：固定数量的对象放在加锁的队列中，取空时阻塞
+struct MutexPool {
+    std::queue<Conn*> pool;
+    std::mutex mtx;
+    std::condition_variable cond;
+    explicit MutexPool(size_t n) { for (size_t i = 0; i < n; ++ i) pool.push(new Conn); }
+    ~MutexPool() { while (!pool.empty()) { delete pool.front(); pool.pop(); } }
+    Conn* acquireObject() {
+        std::unique_lock<std::mutex> lock(mtx);
+        cond.wait(lock, [this]() { return !pool.empty(); });
+        Conn* obj = pool.front();
+        pool.pop();
+        return obj;
+    }
+    void releaseObject(Conn* obj) {
+        std::unique_lock<std::mutex> lock(mtx);
+        pool.push(obj);
+        cond.notify_one();
+    }
+};
+
+// 每个线程反复获取batch个对象再全部归还
+template <typename Pool>
+static double churn(Pool& pool, int threads, int rounds, int batch)
+{
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < threads; ++ i) {
+        workers.emplace_back([&pool, rounds, batch]() {
+            std::vector<Conn*> held(batch);
+            for (int r = 0; r < rounds; ++ r) {
+                for (auto& obj : held) obj = pool.acquireObject();
+                for (auto obj : held) pool.releaseObject(obj);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return elapsedMs(start);
+}
+
+TEST(ObjectPoolBench, Churn) {
+    const int rounds = 20000, batch = 8;
+    for (int threads : {1, 2, 4, 8}) {
+        MutexPool mutexPool(threads * batch);
+        ObjectPool<Conn> lockFreePool(threads * batch, threads * batch * 4);
+        double mutexMs = churn(mutexPool, threads, rounds, batch);
+        double lockFreeMs = churn(lockFreePool, threads, rounds, batch);
+        std::cout << threads << " threads, " << rounds * batch << " acquire/release each: mutex queue "
+                  << mutexMs << " ms, per-thread cache " << lockFreeMs << " ms" << std::endl;
+    }
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include "buffer/linearBuffer.h"
+#include "http/httpParser.h"
+
+static const char REQUEST[] =
+    "GET /css/bootstrap.min.css HTTP/1.1\r\n"
+    "Host: 127.0.0.1:1317\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:120.0) Gecko/20100101 Firefox/120.0\r\n"
+    "Accept: text/css,*/*;q=0.1\r\n"
+    "Accept-Language: zh-CN,zh;q=0.8,en-US;q=0.5,en;q=0.3\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Connection: keep-alive\r\n"
+    "Referer: http://127.0.0.1:1317/index.html\r\n"
+    "\r\n";
+
+// 原来HttpRequest的解析方式：每行拷贝成string，每次调用都构造regex，头部放进unordered_map
+struct RegexRequest {
+    std::string method, path, version;
+    std::unordered_map<std::string, std::string> header;
+
+    bool parse(LinearBuffer& buff) {
+        std::string checkData = buff.justGetData();
+        bool inHeader = false;
+        while (buff.readAbleBytes()) {
+            std::string line = buff.getByEndFlag("\r\n");
+            if (!inHeader) {
+                std::regex patten("^([^ ]*) ([^ ]*) HTTP/([^ ]*)$");
+                std::smatch match;
+                if (!std::regex_match(line, match, patten)) return false;
+                method = match[1];
+                path = match[2];
+                version = match[3];
+                inHeader = true;
+            } else {
+                std::regex patten("^([^:]*): ?(.*)$");
+                std::smatch match;
+                if (std::regex_match(line, match, patten)) {
+                    header[match[1]] = match[2];
+                }
+                if (buff.readAbleBytes() <= 2) {
+                    buff.getReadAbleBytes();
+                    break;
+                }
+            }
+        }
+        return header.count("Connection") && header["Connection"] == "keep-alive" && version == "1.1";
+    }
+};
+
+TEST(ParserBench, RequestsPerCore)
+{
+    const int requests = 200000;
+    // regex版本太慢，只跑一小部分
+    const int regexRequests = 2000;
+    const size_t len = sizeof(REQUEST) - 1;
+    LinearBuffer buff;
+
+    auto start = std::chrono::steady_clock::now();
+    size_t keepAlive = 0;
+    for (int i = 0; i < regexRequests; ++ i) {
+        RegexRequest req;
+        buff.append(REQUEST, len);
+        keepAlive += req.parse(buff);
+    }
+    double regexQps = regexRequests / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(keepAlive, static_cast<size_t>(regexRequests));
+
+    HttpParser parser;
+    std::string method, path, version;
+    keepAlive = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < requests; ++ i) {
+        parser.reset();
+        buff.append(REQUEST, len);
+        ASSERT_EQ(parser.parse(buff.readAddress(), buff.readAbleBytes()), HttpParser::COMPLETE);
+        method.assign(parser.method());
+        path.assign(parser.path());
+        version.assign(parser.version());
+        keepAlive += parser.keepAlive();
+        buff.retrieve(parser.consumed());
+    }
+    double parserQps = requests / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(keepAlive, static_cast<size_t>(requests));
+    EXPECT_EQ(path, "/css/bootstrap.min.css");
+
+    std::cout << "regex " << (long)regexQps << " req/s, HttpParser " << (long)parserQps
+              << " req/s per core" << std::endl;
+}
+
+// 请求被拆成很多次到达时，每次收到数据后从上次停下的位置继续解析
+TEST(ParserBench, PartialReads)
+{
+    const size_t len = sizeof(REQUEST) - 1;
+    const int requests = 20000;
+    LinearBuffer buff;
+    HttpParser parser;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < requests; ++ i) {
+        parser.reset();
+        HttpParser::RESULT ret = HttpParser::INCOMPLETE;
+        for (size_t off = 0; off < len; off += 7) {
+            buff.append(REQUEST + off, std::min<size_t>(7, len - off));
+            ret = parser.parse(buff.readAddress(), buff.readAbleBytes());
+            if (off + 7 < len) {
+                ASSERT_EQ(ret, HttpParser::INCOMPLETE);
+            }
+        }
+        ASSERT_EQ(ret, HttpParser::COMPLETE);
+        ASSERT_EQ(parser.header("user-agent").substr(0, 7), "Mozilla");
+        buff.retrieve(parser.consumed());
+    }
+    double qps = requests / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "HttpParser, 7 bytes per read: " << (long)qps << " req/s per core" << std::endl;
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+#include "server/poller.h"
+#include "server/epoller.h"
+#include "server/uringPoller.h"
+
+// 模拟小请求的长连接：每一轮所有连接各发送一个请求，服务端读取后回复并重新注册ONESHOT事件
+static double keepAliveRequestsPerSecond(Poller* poller, int connNum, int rounds)
+{
+    const char request[] = "GET /index.html HTTP/1.1\r\nHost: 127.0.0.1:1317\r\nConnection: keep-alive\r\n\r\n";
+    const char response[] = "HTTP/1.1 200 OK\r\nConnection: keep-alive\r\nContent-length: 2\r\n\r\nok";
+    const uint32_t connEvent = EPOLLONESHOT | EPOLLRDHUP | EPOLLET;
+
+    std::vector<int> clients(connNum), servers(connNum);
+    for (int i = 0; i < connNum; ++ i) {
+        int sv[2];
+        EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+        clients[i] = sv[0];
+        servers[i] = sv[1];
+        fcntl(servers[i], F_SETFL, fcntl(servers[i], F_GETFL, 0) | O_NONBLOCK);
+        EXPECT_TRUE(poller->addFd(servers[i], connEvent | EPOLLIN));
+    }
+
+    char buff[4096];
+    size_t handled = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++ r) {
+        for (int fd : clients) {
+            EXPECT_EQ(write(fd, request, sizeof(request) - 1), (ssize_t)sizeof(request) - 1);
+        }
+        int remain = connNum;
+        while (remain > 0) {
+            int n = poller->wait(1000);
+            if (n <= 0) {
+                ADD_FAILURE() << "wait returned " << n;
+                return 0;
+            }
+            for (int i = 0; i < n; ++ i) {
+                int fd = poller->getEventFd(i);
+                while (read(fd, buff, sizeof(buff)) > 0) {}
+                EXPECT_GT(write(fd, response, sizeof(response) - 1), 0);
+                poller->modFd(fd, connEvent | EPOLLIN);
+                ++ handled;
+                -- remain;
+            }
+        }
+        for (int fd : clients) {
+            EXPECT_GT(read(fd, buff, sizeof(buff)), 0);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (int i = 0; i < connNum; ++ i) {
+        poller->delFd(servers[i]);
+        close(servers[i]);
+        close(clients[i]);
+    }
+    return handled / seconds;
+}
+
+// 同样的负载使用完成模式：multishot recv收请求，sendmsg回复，不再需要重新注册，也没有read/write系统调用
+static double completionRequestsPerSecond(UringPoller* poller, int connNum, int rounds)
+{
+    const char request[] = "GET /index.html HTTP/1.1\r\nHost: 127.0.0.1:1317\r\nConnection: keep-alive\r\n\r\n";
+    static const char response[] = "HTTP/1.1 200 OK\r\nConnection: keep-alive\r\nContent-length: 2\r\n\r\nok";
+    iovec iov = {const_cast<char*>(response), sizeof(response) - 1};
+
+    std::vector<int> clients(connNum), servers(connNum);
+    for (int i = 0; i < connNum; ++ i) {
+        int sv[2];
+        EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+        clients[i] = sv[0];
+        servers[i] = sv[1];
+        EXPECT_TRUE(poller->recvMulti(servers[i], 1));
+    }
+
+    char buff[4096];
+    size_t handled = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++ r) {
+        for (int fd : clients) {
+            EXPECT_EQ(write(fd, request, sizeof(request) - 1), (ssize_t)sizeof(request) - 1);
+        }
+        // 每个连接收到一个请求并且回复发送完成
+        int remain = connNum * 2;
+        while (remain > 0) {
+            int n = poller->wait(1000);
+            if (n <= 0) {
+                ADD_FAILURE() << "wait returned " << n;
+                return 0;
+            }
+            for (int i = 0; i < n; ++ i) {
+                const Completion* c = poller->getCompletion(i);
+                if (c == nullptr) continue;
+                // 连接数多于接收缓冲区时，请求留在套接字中，下一次wait归还缓冲区之后重新接收
+                if (c->res == -ENOBUFS) {
+                    poller->recvMulti(c->fd, c->gen);
+                    continue;
+                }
+                EXPECT_GT(c->res, 0);
+                if (c->type == COMPLETION_RECV) {
+                    if (!c->more) poller->recvMulti(c->fd, c->gen);
+                    poller->sendMsg(c->fd, c->gen, &iov, 1);
+                    ++ handled;
+                }
+                -- remain;
+            }
+        }
+        for (int fd : clients) {
+            EXPECT_GT(read(fd, buff, sizeof(buff)), 0);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (int i = 0; i < connNum; ++ i) {
+        poller->cancel(servers[i], 1);
+        close(servers[i]);
+        close(clients[i]);
+    }
+    poller->wait(0);
+    return handled / seconds;
+}
+
+TEST(PollerBench, KeepAliveSmallRequests)
+{
+    const int requests = 100000;
+    for (int connNum : {1, 16, 256}) {
+        int rounds = requests / connNum;
+        Epoller epoller;
+        double epollQps = keepAliveRequestsPerSecond(&epoller, connNum, rounds);
+
+        UringPoller uring;
+        if (!uring.valid()) {
+            std::cout << "io_uring is not available, skip" << std::endl;
+            return;
+        }
+        double uringQps = keepAliveRequestsPerSecond(&uring, connNum, rounds);
+
+        UringPoller completion;
+        double completionQps = completion.enableCompletion() ? completionRequestsPerSecond(&completion, connNum, rounds) : 0;
+
+        std::cout << "conn " << connNum << ": epoll " << (long)epollQps << " req/s, io_uring "
+                  << (long)uringQps << " req/s, io_uring completion " << (long)completionQps << " req/s" << std::endl;
+    }
+}
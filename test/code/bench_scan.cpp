@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "http/httpParser.h"
+#include "util/scan.h"
+
+// 浏览器实际发出的请求头
+static const char* BROWSER_REQUESTS[] = {
+    "GET /css/bootstrap.min.css HTTP/1.1\r\n"
+    "Host: 127.0.0.1:1317\r\n"
+    "Connection: keep-alive\r\n"
+    "sec-ch-ua: \"Chromium\";v=\"124\", \"Google Chrome\";v=\"124\", \"Not-A.Brand\";v=\"99\"\r\n"
+    "sec-ch-ua-mobile: ?0\r\n"
+    "User-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/124.0.0.0 Safari/537.36\r\n"
+    "sec-ch-ua-platform: \"Windows\"\r\n"
+    "Accept: text/css,*/*;q=0.1\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Sec-Fetch-Mode: no-cors\r\n"
+    "Sec-Fetch-Dest: style\r\n"
+    "Referer: http://127.0.0.1:1317/index.html\r\n"
+    "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+    "Cookie: _ga=GA1.1.1234567890.1700000000; session=4f3c2a1b9e8d7c6b5a4f3e2d1c0b9a8f; theme=dark\r\n"
+    "\r\n",
+
+    "GET /js/jquery.js HTTP/1.1\r\n"
+    "Host: 127.0.0.1:1317\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:125.0) Gecko/20100101 Firefox/125.0\r\n"
+    "Accept: */*\r\n"
+    "Accept-Language: zh-CN,zh;q=0.8,zh-TW;q=0.7,zh-HK;q=0.5,en-US;q=0.3,en;q=0.2\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Connection: keep-alive\r\n"
+    "Referer: http://127.0.0.1:1317/login.html\r\n"
+    "Sec-Fetch-Dest: script\r\n"
+    "Sec-Fetch-Mode: no-cors\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "\r\n",
+};
+
+static std::vector<scan::Impl> supportedImpls()
+{
+    std::vector<scan::Impl> impls;
+    scan::Impl origin = scan::impl();
+    for (scan::Impl impl : {scan::SCALAR, scan::SSE42, scan::AVX2}) {
+        if (scan::setImpl(impl)) impls.push_back(impl);
+    }
+    scan::setImpl(origin);
+    return impls;
+}
+
+// 所有实现在随机数据上的结果必须和逐字节实现一致
+TEST(ScanBench, ImplsAgree)
+{
+    std::mt19937 rng(1317);
+    const char alphabet[] = "abcXYZ09-_.!~|: \t\r\n\x01\x7f\x80\xff";
+    std::string data(4096, 'a');
+    scan::Impl origin = scan::impl();
+    for (int round = 0; round < 2000; ++ round) {
+        for (auto& c : data) c = alphabet[rng() % (sizeof(alphabet) - 1)];
+        size_t off = rng() % 64;
+        const char* p = data.data() + off;
+        const char* end = data.data() + data.size() - rng() % 64;
+
+        scan::setImpl(scan::SCALAR);
+        const char* ctl = scan::findCtl(p, end);
+        const char* nonToken = scan::findNonToken(p, end);
+        for (scan::Impl impl : supportedImpls()) {
+            scan::setImpl(impl);
+            ASSERT_EQ(scan::findCtl(p, end), ctl) << scan::implName(impl);
+            ASSERT_EQ(scan::findNonToken(p, end), nonToken) << scan::implName(impl);
+        }
+    }
+    scan::setImpl(origin);
+}
+
+TEST(ScanBench, BrowserHeaders)
+{
+    const int requests = 200000;
+    const size_t lens[] = {strlen(BROWSER_REQUESTS[0]), strlen(BROWSER_REQUESTS[1])};
+    scan::Impl origin = scan::impl();
+    for (scan::Impl impl : supportedImpls()) {
+        scan::setImpl(impl);
+        HttpParser parser;
+        size_t bytes = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < requests; ++ i) {
+            const char* req = BROWSER_REQUESTS[i & 1];
+            size_t len = lens[i & 1];
+            parser.reset();
+            ASSERT_EQ(parser.parse(req, len), HttpParser::COMPLETE);
+            ASSERT_TRUE(parser.keepAlive());
+            bytes += len;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << scan::implName(impl) << ": " << (long)(requests / seconds) << " req/s, "
+                  << bytes / seconds / (1 << 20) << " MB/s" << std::endl;
+    }
+    scan::setImpl(origin);
+}
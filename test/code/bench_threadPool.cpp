@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "pool/threadPool.h"
+#include "bench_util.h"
+
+// 模拟事件循环：一个线程连续提交大量很短的任务，等待全部执行完
+// post不创建future，和事件循环提交读写任务的方式相同
+static double reactorSubmit(SCHED_MODE mode, int threads, int tasks, bool post = false)
+{
+    ThreadPool pool(threads, threads, threads, std::chrono::milliseconds(50), mode);
+    pool.init();
+    std::atomic<int> done(0);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < tasks; ++ i) {
+        if (post) {
+            pool.post([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+        else {
+            pool.submit([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+    }
+    while (done.load() < tasks) {
+        std::this_thread::yield();
+    }
+    double ms = elapsedMs(start);
+    pool.shutdown();
+    return ms;
+}
+
+// 模拟事件循环每次唤醒拿到batch个事件，一次提交
+static double reactorBatch(SCHED_MODE mode, int threads, int tasks, int batch)
+{
+    ThreadPool pool(threads, threads, threads, std::chrono::milliseconds(50), mode);
+    pool.init();
+    std::atomic<int> done(0);
+    std::vector<TaskFunc> pending;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < tasks; i += batch) {
+        for (int j = i; j < std::min(tasks, i + batch); ++ j) {
+            pending.emplace_back([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+        pool.submitBatch(pending.data(), pending.size());
+        pending.clear();
+    }
+    while (done.load() < tasks) {
+        std::this_thread::yield();
+    }
+    double ms = elapsedMs(start);
+    pool.shutdown();
+    return ms;
+}
+
+// 任务在工作线程中继续提交子任务
+static double nestedSubmit(SCHED_MODE mode, int threads, int parents, int children)
+{
+    ThreadPool pool(threads, threads, threads, std::chrono::milliseconds(50), mode);
+    pool.init();
+    std::atomic<int> done(0);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < parents; ++ i) {
+        pool.submit([&pool, &done, children]() {
+            for (int j = 0; j < children; ++ j) {
+                pool.submit([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+            }
+        });
+    }
+    while (done.load() < parents * children) {
+        std::this_thread::yield();
+    }
+    double ms = elapsedMs(start);
+    pool.shutdown();
+    return ms;
+}
+
+TEST(ThreadPoolBench, ReactorSubmit)
+{
+    const int tasks = 200000;
+    for (int threads : {2, 4, 8}) {
+        double shared = reactorSubmit(SHARED_QUEUE, threads, tasks);
+        double stealing = reactorSubmit(WORK_STEALING, threads, tasks);
+        double ring = reactorSubmit(LOCK_FREE_QUEUE, threads, tasks);
+        double sharedPost = reactorSubmit(SHARED_QUEUE, threads, tasks, true);
+        double stealingPost = reactorSubmit(WORK_STEALING, threads, tasks, true);
+        double ringPost = reactorSubmit(LOCK_FREE_QUEUE, threads, tasks, true);
+        std::cout << threads << " workers, " << tasks << " tasks: shared queue " << shared
+                  << " ms, work stealing " << stealing << " ms, lock free queue " << ring << " ms" << std::endl;
+        std::cout << threads << " workers, " << tasks << " posts: shared queue " << sharedPost
+                  << " ms, work stealing " << stealingPost << " ms, lock free queue " << ringPost << " ms" << std::endl;
+    }
+}
+
+TEST(ThreadPoolBench, NestedSubmit)
+{
+    const int parents = 200;
+    const int children = 1000;
+    for (int threads : {2, 4, 8}) {
+        double shared = nestedSubmit(SHARED_QUEUE, threads, parents, children);
+        double stealing = nestedSubmit(WORK_STEALING, threads, parents, children);
+        double ring = nestedSubmit(LOCK_FREE_QUEUE, threads, parents, children);
+        std::cout << threads << " workers, " << parents * children << " nested tasks: shared queue " << shared
+                  << " ms, work stealing " << stealing << " ms, lock free queue " << ring << " ms" << std::endl;
+    }
+}
+
+TEST(ThreadPoolBench, ReactorBatch)
+{
+    const int tasks = 200000;
+    const int batch = 64;
+    for (int threads : {2, 4, 8}) {
+        double shared = reactorBatch(SHARED_QUEUE, threads, tasks, batch);
+        double stealing = reactorBatch(WORK_STEALING, threads, tasks, batch);
+        double ring = reactorBatch(LOCK_FREE_QUEUE, threads, tasks, batch);
+        std::cout << threads << " workers, " << tasks << " tasks in batches of " << batch << ": shared queue " << shared
+                  << " ms, work stealing " << stealing << " ms, lock free queue " << ring << " ms" << std::endl;
+    }
+}
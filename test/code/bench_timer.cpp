@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include "timer/heapTimer.h"
+#include "timer/timingWheel.h"
+#include "bench_util.h"
+
+// 10万个空闲长连接：全部加入，按读写事件随机刷新超时，最后一次性到期
+TEST(TimerBench, IdleConnections)
+{
+    const int conns = 100000;
+    const int refreshes = 1000000;
+    std::mt19937 rng(1317);
+    std::vector<int> ids(refreshes);
+    for (auto& id : ids) id = rng() % conns;
+
+    size_t heapExpired = 0;
+    HeapTimer heap;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < conns; ++ i) {
+        heap.add(i, 60000, [&heapExpired]() { ++ heapExpired; });
+    }
+    double heapAdd = elapsedMs(start);
+    start = std::chrono::steady_clock::now();
+    for (int id : ids) {
+        heap.adjust(id, 60000);
+    }
+    double heapRefresh = elapsedMs(start);
+    for (int i = 0; i < conns; ++ i) {
+        heap.add(i, 1, [&heapExpired]() { ++ heapExpired; });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    start = std::chrono::steady_clock::now();
+    heap.tick();
+    double heapExpire = elapsedMs(start);
+    EXPECT_EQ(heapExpired, static_cast<size_t>(conns));
+
+    size_t wheelExpired = 0;
+    TimingWheel wheel([&wheelExpired](WheelNode*) { ++ wheelExpired; });
+    std::vector<WheelNode> nodes(conns);
+    start = std::chrono::steady_clock::now();
+    for (auto& node : nodes) {
+        wheel.add(&node, 60000);
+    }
+    double wheelAdd = elapsedMs(start);
+    start = std::chrono::steady_clock::now();
+    for (int id : ids) {
+        wheel.add(&nodes[id], 60000);
+    }
+    double wheelRefresh = elapsedMs(start);
+    for (auto& node : nodes) {
+        wheel.del(&node);
+        wheel.add(&node, 1);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    start = std::chrono::steady_clock::now();
+    wheel.tick();
+    double wheelExpire = elapsedMs(start);
+    EXPECT_EQ(wheelExpired, static_cast<size_t>(conns));
+    EXPECT_EQ(wheel.size(), 0u);
+
+    std::cout << "add " << conns << ": heap " << heapAdd << " ms, wheel " << wheelAdd << " ms" << std::endl;
+    std::cout << "refresh " << refreshes << ": heap " << heapRefresh << " ms, wheel " << wheelRefresh << " ms" << std::endl;
+    std::cout << "expire " << conns << ": heap " << heapExpire << " ms, wheel " << wheelExpire << " ms" << std::endl;
+}
+
+// 不同超时时间的结点要按时间顺序到期，跨层迁移后也不能提前或者延后太多
+TEST(TimerBench, WheelOrder)
+{
+    std::vector<int> fired;
+    TimingWheel wheel([&fired](WheelNode* node) { fired.push_back(node->data); }, 1);
+    const int timeouts[] = {700, 3, 300, 50, 1, 260, 10};
+    std::vector<WheelNode> nodes(sizeof(timeouts) / sizeof(timeouts[0]));
+    for (size_t i = 0; i < nodes.size(); ++ i) {
+        nodes[i].data = timeouts[i];
+        wheel.add(&nodes[i], timeouts[i]);
+    }
+    // 刷新之后到期时间延后
+    wheel.add(&nodes[1], 400);
+    nodes[1].data = 400;
+
+    auto start = std::chrono::steady_clock::now();
+    while (wheel.size() > 0) {
+        int ms = wheel.GetNextTick();
+        if (ms < 0) break;
+        ASSERT_LE(ms, 256);
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+    EXPECT_GE(elapsedMs(start), 690);
+    EXPECT_EQ(fired, std::vector<int>({1, 10, 50, 260, 300, 400, 700}));
+}
+
+// 空闲时只在结点需要迁移或到期时醒来，不会每转一圈最低层就醒来一次
+TEST(TimerBench, WheelIdleWakeups)
+{
+    int fired = 0;
+    TimingWheel wheel([&fired](WheelNode*) { ++ fired; }, 1);
+    WheelNode node;
+    wheel.add(&node, 2000);
+
+    int wakeups = 0;
+    int ms;
+    while ((ms = wheel.GetNextTick()) >= 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        ++ wakeups;
+    }
+    EXPECT_EQ(fired, 1);
+    EXPECT_LE(wakeups, 3);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <chrono>
+
+// 性能测试共用的计时和本地套接字
+
+inline double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// fds[0]写，fds[1]读，读端非阻塞，一直读到EAGAIN
+// 两端的内核缓冲区都设为1M，大块数据不会被缓冲区大小拆碎；writerNonBlock为true时写端也不阻塞
+inline bool makeSocketPair(int fds[2], bool writerNonBlock = false)
+{
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        return false;
+    }
+    int size = 1 << 20;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+    if (writerNonBlock) {
+        fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    }
+    return true;
+}
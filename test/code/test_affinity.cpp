@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <sched.h>
+#include <thread>
+#include "util/affinity.h"
+
+TEST(AffinityTest, ParseCpuList) {
+    std::vector<int> cpus;
+    ASSERT_TRUE(affinity::parseCpuList("0-3,8,10-11", cpus));
+    ASSERT_EQ(cpus, std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+
+    // 解析失败时不修改结果
+    ASSERT_FALSE(affinity::parseCpuList("3-1", cpus));
+    ASSERT_FALSE(affinity::parseCpuList("a", cpus));
+    ASSERT_EQ(cpus.size(), 7u);
+}
+
+TEST(AffinityTest, ParseConfig) {
+    affinity::Config config;
+    ASSERT_TRUE(affinity::parse(nullptr, config));
+    ASSERT_TRUE(config.empty());
+
+    ASSERT_TRUE(affinity::parse("loops=0-1;workers=2,3;log=4", config));
+    ASSERT_EQ(config.loops, std::vector<int>({0, 1}));
+    ASSERT_EQ(config.workers, std::vector<int>({2, 3}));
+    ASSERT_EQ(config.log, 4);
+
+    ASSERT_FALSE(affinity::parse("log=1-2", config));
+    ASSERT_FALSE(affinity::parse("cpus=1", config));
+    ASSERT_EQ(config.log, 4);
+}
+
+TEST(AffinityTest, PinThread) {
+    // 选一个进程允许使用的CPU，在单独的线程里绑定，不影响测试主线程
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+    int cpu = 0;
+    while (cpu < CPU_SETSIZE && !CPU_ISSET(cpu, &allowed)) {
+        ++ cpu;
+    }
+    ASSERT_LT(cpu, CPU_SETSIZE);
+
+    bool pinned = false;
+    int current = -1;
+    std::thread t([&]() {
+        pinned = affinity::pinThread(cpu);
+        current = sched_getcpu();
+    });
+    t.join();
+    ASSERT_TRUE(pinned);
+    ASSERT_EQ(current, cpu);
+    ASSERT_GE(affinity::numaNode(cpu), 0);
+}
@@ -139,6 +139,94 @@ TEST(CircleBufferTest, ReadByEndBytes)
 }
 
 
+// 可读数据跨过环的末尾时地址仍然连续
+TEST(CircleBufferTest, WrapAround)
+{
+    CircleBuffer buffer(4096);
+    size_t cap = buffer.getCurBufferSize();
+    ASSERT_EQ(cap % 4096, 0);
+
+    std::string head(cap - 10, 'a');
+    buffer.Append(head);
+    buffer.retrieve(head.size());
+    ASSERT_EQ(buffer.readableBytes(), 0);
+
+    // 写位置在环的末尾附近，下面的数据跨过边界
+    std::string line = "GET /wrap/around HTTP/1.1";
+    buffer.Append(line + "\r\n" + "Host: a\r\n");
+    ASSERT_EQ(std::string(buffer.readAddress(), line.size()), line);
+    ASSERT_EQ(buffer.getByEndBytes(), line);
+    ASSERT_EQ(buffer.getByEndBytes(), "Host: a");
+    ASSERT_EQ(buffer.readableBytes(), 0);
+    ASSERT_EQ(buffer.getCurBufferSize(), cap);
+}
+
+// 没有结束符时不取出数据
+TEST(CircleBufferTest, PartialLine)
+{
+    CircleBuffer buffer(4096, "\n");
+    buffer.Append("abc");
+    ASSERT_EQ(buffer.getByEndBytes(), "");
+    ASSERT_EQ(buffer.readableBytes(), 3);
+    buffer.Append("def\nxyz");
+    ASSERT_EQ(buffer.getByEndBytes(), "abcdef");
+    ASSERT_EQ(buffer.getReadableBytes(), "xyz");
+}
+
+// 空间不足时扩容，不丢数据
+TEST(CircleBufferTest, GrowKeepsData)
+{
+    CircleBuffer buffer(4096);
+    size_t cap = buffer.getCurBufferSize();
+    std::string pre(cap / 2, 'p');
+    buffer.Append(pre);
+    buffer.retrieve(cap / 4);
+
+    std::string data;
+    for (size_t i = 0; i < cap * 3; ++ i) {
+        data.push_back('a' + i % 26);
+    }
+    buffer.Append(data);
+    ASSERT_GT(buffer.getCurBufferSize(), cap);
+    ASSERT_EQ(buffer.getReadableBytes(), pre.substr(cap / 4) + data);
+}
+
+// 从fd读入的数据超过初始容量时全部保留
+TEST(CircleBufferTest, WriteInReadOut)
+{
+    int in[2], out[2];
+    ASSERT_EQ(pipe(in), 0);
+    ASSERT_EQ(pipe(out), 0);
+    fcntl(in[0], F_SETFL, O_NONBLOCK);
+
+    CircleBuffer buffer(4096);
+    size_t cap = buffer.getCurBufferSize();
+    std::string data;
+    for (size_t i = 0; i < cap * 2 + 100; ++ i) {
+        data.push_back('a' + i % 26);
+    }
+    ASSERT_EQ(write(in[1], data.data(), data.size()), (ssize_t)data.size());
+
+    while (buffer.readableBytes() < data.size()) {
+        ASSERT_GT(buffer.writeIn(in[0]), 0);
+    }
+    ASSERT_EQ(buffer.readableBytes(), data.size());
+
+    ASSERT_EQ(buffer.readOut(out[1]), (ssize_t)data.size());
+    ASSERT_EQ(buffer.readableBytes(), 0);
+    std::string res(data.size(), 0);
+    size_t got = 0;
+    while (got < res.size()) {
+        ssize_t len = read(out[0], &res[got], res.size() - got);
+        ASSERT_GT(len, 0);
+        got += len;
+    }
+    ASSERT_EQ(res, data);
+
+    close(in[0]); close(in[1]); close(out[0]); close(out[1]);
+}
+
+
 // std::string generateRandomString(size_t length) {
 //     const char charset[] =
 //         "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
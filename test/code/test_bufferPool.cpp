@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "buffer/bufferPool.h"
+#include "buffer/linearBuffer.h"
+
+// 按大小选择级别，超过最大一级时直接分配
+TEST(BufferPoolTest, SizeClasses) {
+    BufferPool* pool = BufferPool::getInstance();
+    size_t before = pool->inUse();
+    size_t capacity;
+    int sizeClass;
+
+    char* small = pool->allocate(100, capacity, sizeClass);
+    ASSERT_EQ(capacity, 4096u);
+    ASSERT_EQ(sizeClass, 0);
+    char* middle = pool->allocate(5000, capacity, sizeClass);
+    ASSERT_EQ(capacity, 16384u);
+    ASSERT_EQ(sizeClass, 1);
+    size_t largeSize = BufferPool::classSize(BUFFER_CLASS_NUM - 1) + 1;
+    char* large = pool->allocate(largeSize, capacity, sizeClass);
+    ASSERT_EQ(capacity, largeSize);
+    ASSERT_EQ(sizeClass, -1);
+    ASSERT_EQ(pool->inUse(), before + 4096 + 16384 + largeSize);
+
+    pool->deallocate(large, largeSize, -1);
+    pool->deallocate(middle, 16384, 1);
+    pool->deallocate(small, 4096, 0);
+    ASSERT_EQ(pool->inUse(), before);
+
+    // 同一个线程归还之后再借用，得到同一块内存
+    char* again = pool->allocate(4096, capacity, sizeClass);
+    ASSERT_EQ(again, small);
+    pool->deallocate(again, capacity, sizeClass);
+}
+
+// 大的级别按内存限制线程缓存，多出来的块进入全局空闲链表，trim之后全部还给系统
+TEST(BufferPoolTest, CacheLimitAndTrim) {
+    BufferPool* pool = BufferPool::getInstance();
+    const int large = BUFFER_CLASS_NUM - 1;
+    ASSERT_EQ(BufferPool::cacheLimit(0), (size_t)BUFFER_CACHE_BLOCKS);
+    ASSERT_EQ(BufferPool::cacheLimit(large), (size_t)BUFFER_CACHE_MEMORY / BufferPool::classSize(large));
+
+    pool->trim();
+    std::thread([pool, large]() {
+        size_t capacity;
+        int sizeClass;
+        std::vector<char*> blocks;
+        for (int i = 0; i < 20; ++ i) {
+            blocks.push_back(pool->allocate(BufferPool::classSize(large), capacity, sizeClass));
+            ASSERT_EQ(sizeClass, large);
+        }
+        for (char* buf : blocks) {
+            pool->deallocate(buf, capacity, sizeClass);
+        }
+        // 本线程最多留下cacheLimit块
+        ASSERT_GE(pool->idle(), (20 - BufferPool::cacheLimit(large)) * BufferPool::classSize(large));
+    }).join();
+    // 线程退出时缓存也还给全局空闲链表
+    ASSERT_EQ(pool->idle(), 20 * BufferPool::classSize(BUFFER_CLASS_NUM - 1));
+    pool->trim();
+    ASSERT_EQ(pool->idle(), 0u);
+}
+
+// 全局空闲的内存超过上限时，多出来的块直接还给系统
+TEST(BufferPoolTest, IdleMemoryLimit) {
+    BufferPool* pool = BufferPool::getInstance();
+    const int large = BUFFER_CLASS_NUM - 1;
+    size_t count = 2 * BUFFER_IDLE_MEMORY / BufferPool::classSize(large);
+    pool->trim();
+    std::thread([pool, count]() {
+        size_t capacity;
+        int sizeClass;
+        std::vector<char*> blocks;
+        for (size_t i = 0; i < count; ++ i) {
+            blocks.push_back(pool->allocate(BufferPool::classSize(BUFFER_CLASS_NUM - 1), capacity, sizeClass));
+        }
+        for (char* buf : blocks) {
+            pool->deallocate(buf, capacity, sizeClass);
+        }
+    }).join();
+    ASSERT_LE(pool->idle(), (size_t)BUFFER_IDLE_MEMORY);
+    pool->trim();
+}
+
+// 第一次写入时才借用空间，数据取完之后可以归还，扩容时保留数据
+TEST(BufferPoolTest, LinearBufferBorrowAndRelease) {
+    BufferPool* pool = BufferPool::getInstance();
+    size_t before = pool->inUse();
+    {
+        LinearBuffer buffer;
+        ASSERT_EQ(buffer.capacity(), 0u);
+        ASSERT_EQ(pool->inUse(), before);
+
+        buffer.append("GET / HTTP/1.1\r\n");
+        ASSERT_EQ(buffer.capacity(), 4096u);
+        std::string large(100000, 'x');
+        buffer.append(large);
+        ASSERT_GE(buffer.capacity(), large.size() + 16);
+        ASSERT_EQ(buffer.getByEndFlag("\r\n"), "GET / HTTP/1.1");
+        ASSERT_EQ(buffer.getDataByLength(large.size()), large);
+
+        // 有数据时不会归还
+        buffer.append("abc");
+        buffer.release();
+        ASSERT_GT(buffer.capacity(), 0u);
+        ASSERT_EQ(buffer.getReadAbleBytes(), "abc");
+        buffer.release();
+        ASSERT_EQ(buffer.capacity(), 0u);
+        ASSERT_EQ(pool->inUse(), before);
+
+        // 归还之后可以继续使用
+        buffer.append("def");
+        ASSERT_EQ(buffer.justGetData(), "def");
+    }
+    ASSERT_EQ(pool->inUse(), before);
+}
+
+TEST(BufferPoolTest, LinearBufferShrinkToFit) {
+    BufferPool* pool = BufferPool::getInstance();
+    size_t before = pool->inUse();
+    {
+        LinearBuffer buffer;
+        buffer.append(std::string(200000, 'x'));
+        size_t large = buffer.capacity();
+        ASSERT_GE(large, 200000u);
+
+        // 清空只移动位置，容量不变
+        buffer.retrieveAll();
+        ASSERT_EQ(buffer.readAbleBytes(), 0u);
+        ASSERT_EQ(buffer.capacity(), large);
+
+        // 剩下一小段数据时换成小块，数据保留
+        buffer.append("GET / HT");
+        buffer.shrinkToFit();
+        ASSERT_EQ(buffer.capacity(), 4096u);
+        ASSERT_EQ(buffer.justGetData(), "GET / HT");
+
+        // 没有数据时全部归还
+        buffer.retrieveAll();
+        buffer.shrinkToFit();
+        ASSERT_EQ(buffer.capacity(), 0u);
+        ASSERT_EQ(pool->inUse(), before);
+    }
+    ASSERT_EQ(pool->inUse(), before);
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <memory>
+#include <string>
+#include "buffer/chainBuffer.h"
+
+// 把对端收到的数据全部读出来
+static std::string drain(int fd)
+{
+    std::string result;
+    char buf[65536];
+    ssize_t len;
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+        result.append(buf, len);
+    }
+    return result;
+}
+
+static void makePair(int fds[2])
+{
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+}
+
+// 连续复制的数据合并成一个切片，静态数据和引用的数据不复制
+TEST(ChainBufferTest, AppendSlices) {
+    ChainBuffer buffer;
+    buffer.append("HTTP/1.1 200 OK\r\n");
+    buffer.append(std::string("Date: today\r\n"));
+    ASSERT_EQ(buffer.sliceCount(), 1u);
+
+    static const char header[] = "Connection: close\r\n\r\n";
+    buffer.appendStatic(header, sizeof(header) - 1);
+    auto body = std::make_shared<std::string>("<html></html>");
+    buffer.appendRef(body->data(), body->size(), body);
+    ASSERT_EQ(buffer.sliceCount(), 3u);
+    ASSERT_EQ(body.use_count(), 2);
+
+    // 引用之后再复制的数据是新的切片
+    buffer.append("tail");
+    ASSERT_EQ(buffer.sliceCount(), 4u);
+    ASSERT_EQ(buffer.toString(), "HTTP/1.1 200 OK\r\nDate: today\r\nConnection: close\r\n\r\n<html></html>tail");
+    ASSERT_EQ(buffer.readAbleBytes(), buffer.toString().size());
+
+    buffer.clear();
+    ASSERT_EQ(buffer.readAbleBytes(), 0u);
+    ASSERT_EQ(body.use_count(), 1);
+}
+
+// 切片数超过IOV_MAX时分多次sendmsg，发送完之后释放引用
+TEST(ChainBufferTest, WriteManySlices) {
+    int fds[2];
+    makePair(fds);
+    ChainBuffer buffer;
+    auto data = std::make_shared<std::string>("0123456789");
+    std::string expect;
+    for (int i = 0; i < 3000; ++i) {
+        buffer.appendRef(data->data() + i % 10, 1, data);
+        expect += (*data)[i % 10];
+    }
+    ASSERT_EQ(buffer.sliceCount(), 3000u);
+
+    int err = 0;
+    ASSERT_GT(buffer.writeFd(fds[0], &err), 0);
+    ASSERT_EQ(buffer.readAbleBytes(), 0u);
+    ASSERT_EQ(data.use_count(), 1);
+    ASSERT_EQ(drain(fds[1]), expect);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+// 文件切片夹在内存切片之间，对端读得慢时分多次发送，顺序不变
+TEST(ChainBufferTest, FileSliceAndPartialWrite) {
+    char path[] = "/tmp/chainBufferXXXXXX";
+    int file = mkstemp(path);
+    ASSERT_GE(file, 0);
+    unlink(path);
+    std::string content;
+    for (int i = 0; i < 200000; ++i) {
+        content += static_cast<char>('a' + i % 26);
+    }
+    ASSERT_EQ(write(file, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+
+    int fds[2];
+    makePair(fds);
+    ChainBuffer buffer;
+    buffer.append("head\r\n");
+    buffer.appendFile(file, 100, content.size() - 100, nullptr);
+    buffer.append("middle\r\n");
+    buffer.appendFile(file, 0, 10, nullptr);
+    buffer.append(std::string(100000, 'z'));
+    std::string expect = "head\r\n" + content.substr(100) + "middle\r\n" + content.substr(0, 10) + std::string(100000, 'z');
+    ASSERT_EQ(buffer.readAbleBytes(), expect.size());
+
+    std::string received;
+    int err = 0;
+    while (buffer.readAbleBytes() > 0) {
+        ssize_t len = buffer.writeFd(fds[0], &err);
+        if (len < 0) {
+            ASSERT_EQ(err, EAGAIN);
+        }
+        received += drain(fds[1]);
+    }
+    received += drain(fds[1]);
+    ASSERT_EQ(received, expect);
+    close(fds[0]);
+    close(fds[1]);
+    close(file);
+}
@@ -1,5 +1,8 @@
 #include "buffer/linearBuffer.h"
 #include <gtest/gtest.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
 
 TEST(BufferTest, TestAppend)
 {
@@ -19,4 +22,40 @@ TEST(BufferTest, TestAppend)
 
     size_t resetBytes = buffer.readAbleBytes();
     ASSERT_EQ(resetBytes, 0);
-}
\ No newline at end of file
+}
+
+// 第一次按预留的大小读，读满之后查询内核中剩下的数据，第二次读完，第三次读到EAGAIN
+TEST(BufferTest, ReadFdLargePending)
+{
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    int size = 1 << 20;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+
+    std::string data;
+    for (size_t i = 0; i < 200000; ++ i) {
+        data.push_back('a' + i % 26);
+    }
+    ssize_t sent = write(fds[0], data.data(), data.size());
+    ASSERT_GT(sent, 0);
+
+    LinearBuffer buffer;
+    int err = 0;
+    ssize_t first = buffer.readFd(fds[1], &err);
+    ASSERT_GT(first, 0);
+    ASSERT_LT(first, sent);
+    ASSERT_EQ(buffer.readFd(fds[1], &err), sent - first);
+    ASSERT_EQ(buffer.readFd(fds[1], &err), -1);
+    ASSERT_EQ(err, EAGAIN);
+    ASSERT_EQ(buffer.getReadAbleBytes(), data.substr(0, sent));
+
+    // 关闭写端后读到EOF
+    buffer.append("rest");
+    close(fds[0]);
+    ASSERT_EQ(buffer.readFd(fds[1], &err), 0);
+    ASSERT_EQ(buffer.getReadAbleBytes(), "rest");
+    close(fds[1]);
+}
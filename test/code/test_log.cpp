@@ -54,3 +54,10 @@ TEST(LogTest, SimePleTest)
 // //         }
 // //     }
 // // }
+
+TEST(LogTest, InitAfterFirstWrite)
+{
+    // 日志已经创建，不能再更换队列
+    LOG_INFO("init after first write");
+    ASSERT_FALSE(Log::init(true));
+}
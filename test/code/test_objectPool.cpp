@@ -1,57 +1,135 @@
 #include <gtest/gtest.h>
-#include "pool/objectPool.h"  // 假设头文件名为 object_pool.h
+#include "pool/objectPool.h"
+#include <atomic>
+#include <set>
 #include <thread>
 #include <vector>
 
 class TestObject {
 public:
-    TestObject() = default;
-    ~TestObject() = default;
+    TestObject(int value = 0) : m_value(value) { ++ alive; }
+    ~TestObject() { -- alive; }
     void doSomething() {
         // 测试对象中的一些行为
+        ++ m_calls;
     }
+
+    int m_value;
+    int m_calls = 0;
+    static std::atomic<int> alive;
 };
 
+std::atomic<int> TestObject::alive(0);
+
 TEST(ObjectPoolTest, AcquireReleaseObject) {
-    // 获取对象池实例
-    auto* pool = ObjectPool<TestObject>::getInstance();
+    ObjectPool<TestObject> pool(2, 8, 7);
 
-    // 从对象池中获取一个对象
-    auto obj = pool->acquireObject();
-    
-    // 确保对象不是空的
+    // 从对象池中获取一个对象，构造参数传给每个对象
+    auto obj = pool.acquireObject();
     ASSERT_NE(obj, nullptr);
-
-    // 调用对象的行为来确保其正常工作
+    ASSERT_EQ(obj->m_value, 7);
     obj->doSomething();
 
-    // 归还对象
-    pool->releaseObject(std::move(obj));
+    // 归还之后同一个线程再次获取，得到刚归还的对象
+    pool.releaseObject(obj);
+    auto obj2 = pool.acquireObject();
+    ASSERT_EQ(obj2, obj);
+    ASSERT_EQ(pool.created(), 2u);
+    pool.releaseObject(obj2);
+}
+
+// 按需创建对象，达到上限后立即返回nullptr，归还之后又可以获取
+TEST(ObjectPoolTest, GrowToLimit) {
+    {
+        ObjectPool<TestObject> pool(1, 40);
+        std::vector<TestObject*> objs;
+        for (int i = 0; i < 40; ++i) {
+            auto obj = pool.acquireObject();
+            ASSERT_NE(obj, nullptr);
+            objs.push_back(obj);
+        }
+        ASSERT_EQ(std::set<TestObject*>(objs.begin(), objs.end()).size(), 40u);
+        ASSERT_EQ(pool.created(), 40u);
+        ASSERT_EQ(pool.acquireObject(), nullptr);
 
-    // 再次获取对象，检查对象池正常复用对象
-    auto obj2 = pool->acquireObject();
-    ASSERT_NE(obj2, nullptr);
+        pool.releaseObject(objs.back());
+        objs.pop_back();
+        ASSERT_NE(pool.acquireObject(), nullptr);
+        ASSERT_EQ(pool.created(), 40u);
+    }
+    // 析构时销毁所有创建过的对象，包括没有归还的
+    ASSERT_EQ(TestObject::alive, 0);
 }
 
+// 一个线程获取、其它线程归还，对象经过全局空闲链表回到获取的线程，不会超过上限
 TEST(ObjectPoolTest, MultiThreadAcquireRelease) {
-    // 获取对象池实例
-    auto* pool = ObjectPool<TestObject>::getInstance();
-
-    // 创建多个线程并从对象池获取对象
-    const int threadCount = 10;
+    const size_t maxSize = 256;
+    ObjectPool<TestObject> pool(16, maxSize);
+    const int threadCount = 4;
     std::vector<std::thread> threads;
+    std::atomic<int> failed(0);
 
     for (int i = 0; i < threadCount; ++i) {
-        threads.emplace_back([pool]() {
-            auto obj = pool->acquireObject();
-            ASSERT_NE(obj, nullptr);
-            obj->doSomething();
-            pool->releaseObject(std::move(obj));
+        threads.emplace_back([&pool, &failed]() {
+            std::vector<TestObject*> held;
+            for (int round = 0; round < 20000; ++round) {
+                auto obj = pool.acquireObject();
+                if (obj == nullptr) {
+                    ++ failed;
+                } else {
+                    obj->doSomething();
+                    held.push_back(obj);
+                }
+                if (held.size() > 20) {
+                    for (auto o : held) pool.releaseObject(o);
+                    held.clear();
+                }
+            }
+            for (auto o : held) pool.releaseObject(o);
         });
     }
-
-    // 等待所有线程完成
     for (auto& t : threads) {
         t.join();
     }
+    ASSERT_LE(pool.created(), maxSize);
+    ASSERT_EQ(failed, 0);
+
+    // 退出的线程已经把缓存还回来，所有对象都可以再次获取
+    std::vector<TestObject*> objs;
+    while (auto obj = pool.acquireObject()) {
+        objs.push_back(obj);
+    }
+    ASSERT_EQ(objs.size(), maxSize);
+    ASSERT_EQ(std::set<TestObject*>(objs.begin(), objs.end()).size(), maxSize);
+}
+
+// 生产者获取、消费者归还，模拟事件循环创建连接、工作线程关闭连接
+TEST(ObjectPoolTest, CrossThreadRelease) {
+    ObjectPool<TestObject> pool(0, 64);
+    std::atomic<TestObject*> box[8];
+    for (auto& b : box) b = nullptr;
+    std::atomic<bool> done(false);
+
+    std::thread consumer([&]() {
+        while (!done) {
+            for (auto& b : box) {
+                if (TestObject* obj = b.exchange(nullptr)) pool.releaseObject(obj);
+            }
+            std::this_thread::yield();
+        }
+    });
+    int acquired = 0;
+    while (acquired < 20000) {
+        for (auto& b : box) {
+            if (b.load() != nullptr) continue;
+            TestObject* obj = pool.acquireObject();
+            if (obj == nullptr) break;
+            b = obj;
+            ++ acquired;
+        }
+        std::this_thread::yield();
+    }
+    done = true;
+    consumer.join();
+    ASSERT_LE(pool.created(), 64u);
 }
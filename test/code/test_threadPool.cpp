@@ -80,4 +80,189 @@ TEST(ThreadPoolTest, TaskPriority) {
     ASSERT_EQ(result[1], 1);
 
     pool.shutdown();
-}
\ No newline at end of file
+}
+// 工作窃取模式：外部提交和工作线程内部提交的任务都要执行完
+TEST(ThreadPoolTest, WorkStealingExecution) {
+    ThreadPool pool(4, 4, 8, std::chrono::milliseconds(100), WORK_STEALING);
+    pool.init();
+
+    std::atomic<int> count(0);
+    std::vector<std::future<void>> results;
+    for (int i = 0; i < 100; ++i) {
+        results.emplace_back(pool.submit([&pool, &count]() {
+            // 工作线程提交的任务进入自己的双端队列，由其它线程窃取
+            for (int j = 0; j < 100; ++j) {
+                pool.submit([&count]() { ++count; });
+            }
+            ++count;
+        }));
+    }
+    for (auto& result : results) {
+        result.get();
+    }
+
+    pool.shutdown();
+    ASSERT_EQ(count, 100 * 100 + 100);
+}
+
+// 工作窃取模式下有优先级的任务先于普通任务执行
+TEST(ThreadPoolTest, WorkStealingPriority) {
+    ThreadPool pool(1, 1, 1, std::chrono::milliseconds(100), WORK_STEALING);
+    pool.init();
+
+    std::vector<int> result;
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    // 唯一的线程被阻塞，后面的任务都在队列中等待
+    auto blocker = pool.submit([opened]() { opened.wait(); });
+    auto normal = pool.submit([&result]() { result.push_back(0); });
+    auto high = pool.submit(10, [&result]() { result.push_back(10); });
+    gate.set_value();
+
+    blocker.get();
+    normal.get();
+    high.get();
+    ASSERT_EQ(result[0], 10);
+    ASSERT_EQ(result[1], 0);
+
+    pool.shutdown();
+}
+
+// post提交的任务没有返回值，可以捕获只能移动的对象和超过内联大小的对象
+TEST(ThreadPoolTest, PostTask) {
+    ThreadPool pool(2, 2, 2, std::chrono::milliseconds(100), WORK_STEALING);
+    pool.init();
+
+    std::promise<int> small;
+    std::promise<int> large;
+    std::unique_ptr<int> value(new int(7));
+    char padding[128] = {1};
+    pool.post([&small, value = std::move(value)]() { small.set_value(*value); });
+    pool.post(5, [&large, padding]() { large.set_value(padding[0] + 1); });
+
+    ASSERT_EQ(small.get_future().get(), 7);
+    ASSERT_EQ(large.get_future().get(), 2);
+
+    pool.shutdown();
+}
+
+// 无锁队列模式：多个线程同时提交，任务都要执行完，有优先级的任务也能执行
+TEST(ThreadPoolTest, LockFreeQueueExecution) {
+    ThreadPool pool(4, 4, 4, std::chrono::milliseconds(100), LOCK_FREE_QUEUE);
+    pool.init();
+
+    std::atomic<int> count(0);
+    std::vector<std::thread> producers;
+    for (int i = 0; i < 4; ++i) {
+        producers.emplace_back([&pool, &count]() {
+            for (int j = 0; j < 10000; ++j) {
+                pool.post(j % 100 == 0 ? 1 : 0, [&count]() { ++count; });
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    auto last = pool.submit([]() { return 1; });
+    ASSERT_EQ(last.get(), 1);
+
+    pool.shutdown();
+    ASSERT_EQ(count, 4 * 10000);
+}
+
+// 无锁队列模式：环形队列满时溢出的任务仍然按提交顺序执行
+TEST(ThreadPoolTest, LockFreeQueueOverflowOrder) {
+    ThreadPool pool(1, 1, 1, std::chrono::milliseconds(100), LOCK_FREE_QUEUE);
+    pool.init();
+
+    // 唯一的工作线程被挡住，提交的任务超过环形队列的容量
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    pool.post([opened]() { opened.wait(); });
+
+    const int total = TASK_RING_SIZE * 3;
+    std::vector<int> order;
+    order.reserve(total);
+    int next = 0;
+    for (; next < total / 2; ++next) {
+        pool.post([&order, next]() { order.push_back(next); });
+    }
+    std::vector<TaskFunc> tasks;
+    for (; next < total; ++next) {
+        tasks.emplace_back([&order, next]() { order.push_back(next); });
+    }
+    pool.submitBatch(tasks.data(), tasks.size());
+    gate.set_value();
+
+    pool.shutdown();
+    ASSERT_EQ(order.size(), (size_t)total);
+    for (int i = 0; i < total; ++i) {
+        ASSERT_EQ(order[i], i);
+    }
+}
+
+// 批量提交的任务在每种模式下都要执行完，提交之后数组中的任务被移走
+TEST(ThreadPoolTest, SubmitBatch) {
+    for (SCHED_MODE mode : {SHARED_QUEUE, WORK_STEALING, LOCK_FREE_QUEUE}) {
+        ThreadPool pool(4, 4, 4, std::chrono::milliseconds(100), mode);
+        pool.init();
+
+        std::atomic<int> count(0);
+        std::vector<TaskFunc> tasks;
+        for (int i = 0; i < 1000; ++i) {
+            tasks.emplace_back([&count]() { ++count; });
+        }
+        pool.submitBatch(tasks.data(), tasks.size());
+        for (auto& task : tasks) {
+            ASSERT_FALSE(task);
+        }
+
+        pool.shutdown();
+        ASSERT_EQ(count, 1000);
+    }
+}
+
+// 排队时间超过目标时扩容，空闲之后逐步缩回最小线程数
+TEST(ThreadPoolTest, AdaptiveResize) {
+    for (SCHED_MODE mode : {SHARED_QUEUE, WORK_STEALING, LOCK_FREE_QUEUE}) {
+        ThreadPool pool(1, 1, 8, std::chrono::milliseconds(20), mode);
+        PoolTuning tuning;
+        tuning.targetWaitUs = 5000;
+        tuning.shrinkTicks = 3;
+        pool.setTuning(tuning);
+        pool.init();
+
+        std::vector<std::future<void>> results;
+        for (int i = 0; i < 32; ++i) {
+            results.emplace_back(pool.submit(1, []() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); }));
+        }
+        for (auto& result : results) {
+            result.get();
+        }
+        PoolStats stats = pool.stats();
+        ASSERT_GT(stats.grows, 0u);
+
+        // 缩容有滞后，等待回到最小线程数
+        for (int i = 0; i < 100 && pool.stats().threads > 1; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        stats = pool.stats();
+        ASSERT_EQ(stats.threads, 1u);
+        ASSERT_GT(stats.shrinks, 0u);
+        ASSERT_EQ(stats.queued, 0u);
+        ASSERT_EQ(stats.completed, 32u);
+
+        // 缩容之后仍然可以执行任务
+        ASSERT_EQ(pool.submit(1, []() { return 7; }).get(), 7);
+        pool.shutdown();
+    }
+}
+
+// 关闭时不需要等待控制周期结束
+TEST(ThreadPoolTest, FastShutdown) {
+    ThreadPool pool(2, 2, 4, std::chrono::milliseconds(5000));
+    pool.init();
+    auto start = std::chrono::steady_clock::now();
+    pool.shutdown();
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}